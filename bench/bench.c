@@ -0,0 +1,290 @@
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <ode.h>
+#include "problemi.h"
+
+/*! \brief Risultato di un metodo su un problema
+ */
+struct Misura{
+  gsl_matrix* O_sim; /*!< Risultato per righe*/
+  size_t ultimo; /*!< Indice dell'ultimo stato calcolato*/
+  double tFinale; /*!< Istante dell'ultimo stato calcolato*/
+  size_t passi; /*!< Numero di passi accettati*/
+};
+
+typedef void (*MetodoBench)(struct InfoBaseSimulazione*,gsl_vector*,struct Misura*);
+
+static double A_RK4[16]={
+  0.0,0.0,0.0,0.0,
+  0.5,0.0,0.0,0.0,
+  0.0,0.5,0.0,0.0,
+  0.0,0.0,1.0,0.0
+};
+static double B_RK4[4]={1.0/6.0,1.0/3.0,1.0/3.0,1.0/6.0};
+
+//Misura dei metodi a passo fisso a partire da indiceCondizione
+static void PassoFisso(struct InfoBaseSimulazione* info,gsl_matrix* O_sim,struct Misura* misura){
+  misura->O_sim=O_sim;
+  misura->ultimo=*(info->indiceCondizione);
+  misura->passi=misura->ultimo;
+  misura->tFinale=info->t0+((double)misura->ultimo)*info->h;
+}
+
+static void BenchEuleroAvanti(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  PassoFisso(info,EuleroAvanti(info,x0),misura);
+}
+
+static void BenchEuleroIndietro(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  PassoFisso(info,EuleroIndietro(info,x0),misura);
+}
+
+static void BenchCrankNicolson(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  PassoFisso(info,CrankNicolson(info,x0),misura);
+}
+
+static void BenchHeun(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  PassoFisso(info,Heun(info,x0),misura);
+}
+
+static void BenchRosenbrockW(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  PassoFisso(info,RosenbrockW(info,x0),misura);
+}
+
+static void BenchRK4(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  PassoFisso(info,RungeKuttaEsplicito(info,A_RK4,B_RK4,4,x0),misura);
+}
+
+//Innesco di un LMM a due passi con un passo del metodo dato
+static gsl_matrix* Innesco(struct InfoBaseSimulazione* info,gsl_vector* x0,bool implicito){
+  struct InfoBaseSimulazione infoInnesco=*info;
+  infoInnesco.T=info->h;
+  infoInnesco.disposizione=DisposizioneColonne;
+  infoInnesco.tCondizione=NULL;
+  infoInnesco.indiceCondizione=NULL;
+  infoInnesco.statistiche=NULL;
+  return implicito ? EuleroIndietro(&infoInnesco,x0) : RungeKuttaEsplicito(&infoInnesco,A_RK4,B_RK4,4,x0);
+}
+
+static void BenchAB2(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  double A[2]={1.0,0.0}, B[2]={1.5,-0.5};
+  gsl_matrix* innesco=Innesco(info,x0,false);
+  PassoFisso(info,LMM(info,A,B,0.0,innesco),misura);
+  gsl_matrix_free(innesco);
+}
+
+static void BenchBDF2(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  double A[2]={4.0/3.0,-1.0/3.0}, B[2]={0.0,0.0};
+  gsl_matrix* innesco=Innesco(info,x0,true);
+  PassoFisso(info,LMM(info,A,B,2.0/3.0,innesco),misura);
+  gsl_matrix_free(innesco);
+}
+
+static void Adattivo(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura,const double* A,const double* B,const double* Bc,unsigned stadi,unsigned ordine,const double* D){
+  struct InfoAdattivo infoAdattivo={1e-6,1e-6,ordine,0.0,0.0,0.0,0.0,0,D};
+  struct InfoBaseSimulazione infoPasso=*info;
+  infoPasso.h=0.0;
+  gsl_vector* istanti;
+  misura->O_sim=RungeKuttaAdattivo(&infoPasso,&infoAdattivo,A,B,Bc,stadi,x0,&istanti);
+  misura->ultimo=istanti->size-1;
+  misura->passi=misura->ultimo;
+  misura->tFinale=gsl_vector_get(istanti,misura->ultimo);
+  gsl_vector_free(istanti);
+}
+
+static void BenchDormandPrince(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  Adattivo(info,x0,misura,DormandPrince_A,DormandPrince_B,DormandPrince_Bcappello,7,4,DormandPrince_D);
+}
+
+static void BenchBogackiShampine(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  Adattivo(info,x0,misura,BogackiShampine_A,BogackiShampine_B,BogackiShampine_Bcappello,4,2,NULL);
+}
+
+static void Multipasso(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura,enum FamigliaMultipasso famiglia){
+  struct InfoMultipasso infoMultipasso={famiglia,1e-6,1e-6,0,0.0,0.0,0,NULL,0,0};
+  struct InfoBaseSimulazione infoPasso=*info;
+  infoPasso.h=0.0;
+  gsl_vector* istanti;
+  misura->O_sim=MultipassoAdattivo(&infoPasso,&infoMultipasso,x0,&istanti);
+  misura->ultimo=istanti->size-1;
+  misura->passi=misura->ultimo;
+  misura->tFinale=gsl_vector_get(istanti,misura->ultimo);
+  gsl_vector_free(istanti);
+}
+
+static void BenchAdams(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  Multipasso(info,x0,misura,Adams);
+}
+
+static void BenchBDF(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  Multipasso(info,x0,misura,BDF);
+}
+
+static void BenchAutomatica(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  Multipasso(info,x0,misura,Automatica);
+}
+
+//Problema in misura, per la forza dei metodi simplettici
+static const struct Problema* ProblemaCorrente;
+
+static void BenchSimplettico(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura,enum MetodoSimplettico metodo){
+  struct InfoSimplettico infoSimplettico={metodo,ProblemaCorrente->forza,NULL,NULL,NULL,0};
+  PassoFisso(info,Simplettico(info,&infoSimplettico,x0),misura);
+}
+
+static void BenchStormerVerlet(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  BenchSimplettico(info,x0,misura,StormerVerlet);
+}
+
+static void BenchYoshida4(struct InfoBaseSimulazione* info,gsl_vector* x0,struct Misura* misura){
+  BenchSimplettico(info,x0,misura,Yoshida4);
+}
+
+static const struct{
+  const char* nome;
+  MetodoBench metodo;
+  bool simplettico; //Se vero il metodo viene misurato solo sui problemi con la forza
+} Metodi[]={
+  {"eulero_avanti",BenchEuleroAvanti,false},
+  {"eulero_indietro",BenchEuleroIndietro,false},
+  {"crank_nicolson",BenchCrankNicolson,false},
+  {"heun",BenchHeun,false},
+  {"rk4",BenchRK4,false},
+  {"rosenbrock_w",BenchRosenbrockW,false},
+  {"ab2",BenchAB2,false},
+  {"bdf2",BenchBDF2,false},
+  {"dormand_prince",BenchDormandPrince,false},
+  {"bogacki_shampine",BenchBogackiShampine,false},
+  {"adams",BenchAdams,false},
+  {"bdf",BenchBDF,false},
+  {"automatica",BenchAutomatica,false},
+  {"stormer_verlet",BenchStormerVerlet,true},
+  {"yoshida4",BenchYoshida4,true}
+};
+
+//Soluzione di riferimento: esatta se nota, altrimenti Dormand-Prince con tolleranze strette
+static void Riferimento(const struct Problema* problema,double t,gsl_vector* riferimento){
+  if(problema->esatta){
+    problema->esatta(t,riferimento);
+    return;
+  }
+  struct InfoBaseSimulazione info={problema->dinamica,NULL,NULL,NULL,problema->t0,t-problema->t0,0.0,NULL,DisposizioneRighe,NULL,NULL,NULL,NULL,NULL,NULL};
+  struct InfoAdattivo infoAdattivo={1e-14,1e-12,4,0.0,0.0,0.0,0.0,0,NULL};
+  gsl_vector* x0=gsl_vector_alloc(problema->n);
+  problema->iniziale(x0);
+  gsl_matrix* O_sim=RungeKuttaAdattivo(&info,&infoAdattivo,DormandPrince_A,DormandPrince_B,DormandPrince_Bcappello,7,x0,NULL);
+  gsl_vector_view finale=gsl_matrix_row(O_sim,O_sim->size1-1);
+  gsl_vector_memcpy(riferimento,&(finale.vector));
+  gsl_matrix_free(O_sim);
+  gsl_vector_free(x0);
+}
+
+//Errore relativo in norma infinito
+static double Errore(const gsl_vector* x,const gsl_vector* riferimento){
+  double differenza=0.0, norma=0.0;
+  for(size_t i=0; i<x->size; ++i){
+    double d=fabs(gsl_vector_get(x,i)-gsl_vector_get(riferimento,i));
+    if(!(d <= differenza)) differenza=d;
+    norma=GSL_MAX(norma,fabs(gsl_vector_get(riferimento,i)));
+  }
+  return norma > 0.0 ? differenza/norma : differenza;
+}
+
+static double Secondi(void){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return (double)t.tv_sec+1e-9*(double)t.tv_nsec;
+}
+
+//Verifica degli eventi: su y'=1 i metodi a passo fisso sono esatti, quindi l'evento terminale y=0.55 deve cadere in t=0.55 per tutti
+static void DinamicaCostante(double t,gsl_vector* x,gsl_vector* f){
+  (void)t;
+  (void)x;
+  gsl_vector_set_all(f,1.0);
+}
+
+static double EventoSoglia(double t,gsl_vector* x){
+  (void)t;
+  return gsl_vector_get(x,0)-0.55;
+}
+
+static bool VerificaEventi(void){
+  gsl_matrix* (*const metodi[3])(struct InfoBaseSimulazione*,gsl_vector*)={EuleroAvanti,Heun,CrankNicolson};
+  const char* nomi[3]={"eulero_avanti","heun","crank_nicolson"};
+  struct Evento evento={EventoSoglia,EventoCrescente,true,NULL};
+  gsl_vector* x0=gsl_vector_alloc(1);
+  gsl_vector_set_zero(x0);
+  bool corretto=true;
+  for(size_t m=0; m<3; ++m){
+    struct InfoEventi eventi={&evento,1,0.0,0,NULL,NULL,NULL,0,false};
+    double tEvento=GSL_NAN;
+    struct InfoBaseSimulazione info={DinamicaCostante,NULL,&tEvento,NULL,0.0,1.0,0.1,NULL,DisposizioneRighe,&eventi,NULL,NULL,NULL,NULL,NULL};
+    gsl_matrix_free(metodi[m](&info,x0));
+    if(!eventi.terminato || !(fabs(tEvento-0.55) <= 1e-10)){
+      fprintf(stderr,"bench: evento di %s in t=%.17g invece di 0.55\n",nomi[m],tEvento);
+      corretto=false;
+    }
+  }
+  gsl_vector_free(x0);
+  return corretto;
+}
+
+int main(int argc,char** argv){
+  const bool json= argc > 1 && strcmp(argv[1],"json") == 0;
+  if(!VerificaEventi()) return 1;
+  const size_t numeroMetodi=sizeof(Metodi)/sizeof(Metodi[0]);
+  struct InfoImplicito newton={Newton,NULL,0.0,0,0.0,JacobianoDenso,0,0,NULL,NULL,0.0,0,NULL};
+
+  if(json) printf("[\n");
+  else printf("problema,metodo,n,h,passi,passi_rifiutati,chiamate_dinamica,iterazioni,passi_non_convergenti,jacobiani,fattorizzazioni,iterazioni_lineari,tempo_s,tempo_dinamica_s,passi_al_s,errore\n");
+  bool primo=true;
+  for(size_t p=0; p<NumeroProblemi; ++p){
+    const struct Problema* problema=&(Problemi[p]);
+    gsl_vector* x0=gsl_vector_alloc(problema->n);
+    gsl_vector* riferimento=gsl_vector_alloc(problema->n);
+    problema->iniziale(x0);
+    double tRiferimento=GSL_NAN;
+    ProblemaCorrente=problema;
+
+    for(size_t m=0; m<numeroMetodi; ++m){
+      if(Metodi[m].simplettico && problema->forza == NULL) continue;
+      size_t indice=0;
+      struct Statistiche statistiche;
+      struct InfoBaseSimulazione info={problema->dinamica,NULL,NULL,&indice,problema->t0,problema->T,problema->h,problema->rigido ? &newton : NULL,DisposizioneRighe,NULL,&statistiche,NULL,NULL,NULL,NULL};
+      struct Misura misura;
+      ChiamateDinamica=0;
+      double inizio=Secondi();
+      Metodi[m].metodo(&info,x0,&misura);
+      double tempo=Secondi()-inizio;
+      unsigned long chiamate=ChiamateDinamica;
+
+      //Il riferimento viene ricalcolato solo se l'istante finale cambia
+      if(!(misura.tFinale == tRiferimento)){
+        Riferimento(problema,misura.tFinale,riferimento);
+        tRiferimento=misura.tFinale;
+      }
+      gsl_vector_view finale=gsl_matrix_row(misura.O_sim,misura.ultimo);
+      double errore=Errore(&(finale.vector),riferimento);
+      double passiAlSecondo= tempo > 0.0 ? (double)misura.passi/tempo : 0.0;
+
+      if(json){
+        printf("%s  {\"problema\": \"%s\", \"metodo\": \"%s\", \"n\": %zu, \"h\": %g, \"passi\": %zu, \"passi_rifiutati\": %zu, \"chiamate_dinamica\": %lu, "
+               "\"iterazioni\": %zu, \"passi_non_convergenti\": %zu, \"jacobiani\": %zu, \"fattorizzazioni\": %zu, \"iterazioni_lineari\": %zu, \"tempo_s\": %.6e, \"tempo_dinamica_s\": %.6e, \"passi_al_s\": %.6e, \"errore\": ",
+               primo ? "" : ",\n",problema->nome,Metodi[m].nome,problema->n,problema->h,misura.passi,statistiche.passiRifiutati,chiamate,
+               statistiche.iterazioni,statistiche.passiNonConvergenti,statistiche.jacobiani,statistiche.fattorizzazioni,statistiche.iterazioniLineari,tempo,statistiche.tempoDinamica,passiAlSecondo);
+        //JSON non ammette inf e nan
+        if(isfinite(errore)) printf("%.6e}",errore);
+        else printf("null}");
+      }else{
+        printf("%s,%s,%zu,%g,%zu,%zu,%lu,%zu,%zu,%zu,%zu,%zu,%.6e,%.6e,%.6e,%.6e\n",problema->nome,Metodi[m].nome,problema->n,problema->h,misura.passi,statistiche.passiRifiutati,chiamate,
+               statistiche.iterazioni,statistiche.passiNonConvergenti,statistiche.jacobiani,statistiche.fattorizzazioni,statistiche.iterazioniLineari,tempo,statistiche.tempoDinamica,passiAlSecondo,errore);
+      }
+      primo=false;
+      gsl_matrix_free(misura.O_sim);
+    }
+    gsl_vector_free(x0);
+    gsl_vector_free(riferimento);
+  }
+  if(json) printf("\n]\n");
+  return 0;
+}
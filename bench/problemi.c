@@ -0,0 +1,149 @@
+#include <math.h>
+#include "problemi.h"
+
+unsigned long ChiamateDinamica=0;
+
+//Lorenz con i parametri classici, caotico: il periodo e' breve per avere un riferimento significativo
+static void Lorenz(double t,gsl_vector* x,gsl_vector* dx){
+  (void)t;
+  ++ChiamateDinamica;
+  const double sigma=10.0, rho=28.0, beta=8.0/3.0;
+  double x0=gsl_vector_get(x,0), x1=gsl_vector_get(x,1), x2=gsl_vector_get(x,2);
+  gsl_vector_set(dx,0,sigma*(x1-x0));
+  gsl_vector_set(dx,1,x0*(rho-x2)-x1);
+  gsl_vector_set(dx,2,x0*x1-beta*x2);
+}
+
+static void LorenzIniziale(gsl_vector* x){
+  gsl_vector_set_all(x,1.0);
+}
+
+//Van der Pol, mu=1 non rigido e mu=1000 rigido
+static void VanDerPol(double mu,gsl_vector* x,gsl_vector* dx){
+  ++ChiamateDinamica;
+  double x0=gsl_vector_get(x,0), x1=gsl_vector_get(x,1);
+  gsl_vector_set(dx,0,x1);
+  gsl_vector_set(dx,1,mu*(1.0-x0*x0)*x1-x0);
+}
+
+static void VanDerPolLieve(double t,gsl_vector* x,gsl_vector* dx){
+  (void)t;
+  VanDerPol(1.0,x,dx);
+}
+
+static void VanDerPolRigido(double t,gsl_vector* x,gsl_vector* dx){
+  (void)t;
+  VanDerPol(1000.0,x,dx);
+}
+
+static void VanDerPolIniziale(gsl_vector* x){
+  gsl_vector_set(x,0,2.0);
+  gsl_vector_set(x,1,0.0);
+}
+
+//Cinetica chimica di Robertson
+static void Robertson(double t,gsl_vector* x,gsl_vector* dx){
+  (void)t;
+  ++ChiamateDinamica;
+  double x0=gsl_vector_get(x,0), x1=gsl_vector_get(x,1), x2=gsl_vector_get(x,2);
+  gsl_vector_set(dx,0,-0.04*x0+1e4*x1*x2);
+  gsl_vector_set(dx,1,0.04*x0-1e4*x1*x2-3e7*x1*x1);
+  gsl_vector_set(dx,2,3e7*x1*x1);
+}
+
+static void RobertsonIniziale(gsl_vector* x){
+  gsl_vector_set(x,0,1.0);
+  gsl_vector_set(x,1,0.0);
+  gsl_vector_set(x,2,0.0);
+}
+
+//Equazione del calore u_t=u_xx su (0,1) con differenze centrate su NumeroNodi nodi interni e bordi nulli
+#define NumeroNodi 200
+static const double dx=1.0/(NumeroNodi+1.0);
+
+static void Calore(double t,gsl_vector* u,gsl_vector* du){
+  (void)t;
+  ++ChiamateDinamica;
+  const double k=1.0/(dx*dx);
+  for(size_t i=0; i<NumeroNodi; ++i){
+    double sinistra= i > 0 ? gsl_vector_get(u,i-1) : 0.0;
+    double destra= i+1 < NumeroNodi ? gsl_vector_get(u,i+1) : 0.0;
+    gsl_vector_set(du,i,k*(sinistra-2.0*gsl_vector_get(u,i)+destra));
+  }
+}
+
+//sin(pi*x) e' un autovettore della matrice discreta, quindi la soluzione del sistema semidiscreto e' nota
+static void CaloreEsatta(double t,gsl_vector* u){
+  const double s=sin(M_PI*dx/2.0);
+  const double lambda=4.0*s*s/(dx*dx);
+  for(size_t i=0; i<NumeroNodi; ++i) gsl_vector_set(u,i,sin(M_PI*dx*(double)(i+1))*exp(-lambda*t));
+}
+
+static void CaloreIniziale(gsl_vector* u){
+  CaloreEsatta(0.0,u);
+}
+
+//Problema a N corpi nel piano: un corpo centrale e quattro pianeti su orbite circolari, con G=1
+#define NumeroCorpi 5
+static const double Masse[NumeroCorpi]={1.0,1e-3,1e-3,1e-3,1e-3};
+
+//Accelerazioni dei corpi nelle posizioni q, le prime 2*NumeroCorpi componenti di q
+static void NCorpiAccelerazioni(gsl_vector* q,gsl_vector* a){
+  for(size_t i=0; i<NumeroCorpi; ++i){
+    double ax=0.0, ay=0.0;
+    for(size_t j=0; j<NumeroCorpi; ++j){
+      if(i == j) continue;
+      double rx=gsl_vector_get(q,2*j)-gsl_vector_get(q,2*i);
+      double ry=gsl_vector_get(q,2*j+1)-gsl_vector_get(q,2*i+1);
+      double r2=rx*rx+ry*ry;
+      double f=Masse[j]/(r2*sqrt(r2));
+      ax+=f*rx;
+      ay+=f*ry;
+    }
+    gsl_vector_set(a,2*i,ax);
+    gsl_vector_set(a,2*i+1,ay);
+  }
+}
+
+//Stato: posizioni (x,y) di tutti i corpi seguite dalle velocita'
+static void NCorpi(double t,gsl_vector* x,gsl_vector* dx){
+  (void)t;
+  ++ChiamateDinamica;
+  const size_t v=2*NumeroCorpi;
+  for(size_t i=0; i<v; ++i) gsl_vector_set(dx,i,gsl_vector_get(x,v+i));
+  gsl_vector_view a=gsl_vector_subvector(dx,v,v);
+  NCorpiAccelerazioni(x,&(a.vector));
+}
+
+//Con le velocita' come momenti (masse unitarie nell'hamiltoniano) la forza e' l'accelerazione
+static void NCorpiForza(double t,gsl_vector* q,gsl_vector* F,void* parametri){
+  (void)t;
+  (void)parametri;
+  ++ChiamateDinamica;
+  NCorpiAccelerazioni(q,F);
+}
+
+static void NCorpiIniziale(gsl_vector* x){
+  static const double raggi[NumeroCorpi]={0.0,1.0,1.5,2.0,3.0};
+  const size_t v=2*NumeroCorpi;
+  gsl_vector_set_zero(x);
+  for(size_t i=1; i<NumeroCorpi; ++i){
+    double angolo=(double)i;
+    gsl_vector_set(x,2*i,raggi[i]*cos(angolo));
+    gsl_vector_set(x,2*i+1,raggi[i]*sin(angolo));
+    double velocita=sqrt(Masse[0]/raggi[i]);
+    gsl_vector_set(x,v+2*i,-velocita*sin(angolo));
+    gsl_vector_set(x,v+2*i+1,velocita*cos(angolo));
+  }
+}
+
+const struct Problema Problemi[]={
+  {"lorenz",3,Lorenz,0.0,2.0,1e-3,false,LorenzIniziale,NULL,NULL},
+  {"vanderpol_lieve",2,VanDerPolLieve,0.0,10.0,1e-2,false,VanDerPolIniziale,NULL,NULL},
+  {"vanderpol_rigido",2,VanDerPolRigido,0.0,1.0,1e-3,true,VanDerPolIniziale,NULL,NULL},
+  {"robertson",3,Robertson,0.0,10.0,1e-3,true,RobertsonIniziale,NULL,NULL},
+  {"calore",NumeroNodi,Calore,0.0,0.1,1e-3,true,CaloreIniziale,CaloreEsatta,NULL},
+  {"n_corpi",4*NumeroCorpi,NCorpi,0.0,10.0,1e-3,false,NCorpiIniziale,NULL,NCorpiForza}
+};
+
+const size_t NumeroProblemi=sizeof(Problemi)/sizeof(Problemi[0]);
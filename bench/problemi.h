@@ -0,0 +1,29 @@
+/*! \file problemi.h
+ *  \brief Problemi di prova usati dal benchmark dei metodi
+ */
+#ifndef PROBLEMI_H
+#define PROBLEMI_H
+
+#include <ode.h>
+
+extern unsigned long ChiamateDinamica; /*!< Numero di chiamate alla dinamica dall'ultimo azzeramento, incrementato da tutti i problemi*/
+
+/*! \brief Struttura dati per un problema di prova
+ */
+struct Problema{
+  const char* nome; /*!< Nome del problema nei risultati*/
+  size_t n; /*!< Dimensione dello stato*/
+  ODE dinamica; /*!< Dinamica del problema*/
+  double t0; /*!< Istante iniziale*/
+  double T; /*!< Periodo di integrazione*/
+  double h; /*!< Passo dei metodi a passo fisso*/
+  bool rigido; /*!< Se vero i metodi impliciti usano Newton invece del punto fisso*/
+  void (*iniziale)(gsl_vector*); /*!< Scrive lo stato iniziale*/
+  void (*esatta)(double,gsl_vector*); /*!< Soluzione esatta all'istante dato, nullptr per calcolare il riferimento numericamente*/
+  Forza forza; /*!< Forza per i metodi simplettici con stato [q, p] e dq/dt=p, nullptr se il problema non e' hamiltoniano separabile*/
+};
+
+extern const struct Problema Problemi[]; /*!< Problemi di prova*/
+extern const size_t NumeroProblemi; /*!< Numero di problemi di prova*/
+
+#endif
@@ -1,26 +1,346 @@
 /*! \file ode.h
  *  \brief File header per la dichiarazione delle funzioni dei metodi
  */
+#ifndef ODE_H
+#define ODE_H
+
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_matrix.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 typedef void (*ODE)(double,gsl_vector*,gsl_vector*); /*!< Tipo di dato per le funzioni ODE, cioè la dinamica. I parametri sono in ordine tempo,stato,calcolo della derivata*/
 typedef bool (*Condizione)(double,gsl_vector*); /*!< Tipo di dato per le funzioni delle condizioni di uscita. I parametri sono in ordine tempo,stato*/
+typedef void (*FunzioneUscita)(double,gsl_vector*,void*); /*!< Tipo di dato per le funzioni che ricevono gli stati calcolati in flusso. I parametri sono in ordine tempo,stato,dati dell'utente*/
+typedef void (*ODEInsieme)(double,gsl_matrix*,gsl_matrix*,size_t); /*!< Tipo di dato per la dinamica di un blocco di membri di un insieme. I parametri sono in ordine tempo,stati,calcolo delle derivate,indice del primo membro del blocco. Ogni colonna delle matrici è un membro e ogni riga una componente dello stato*/
+typedef void (*Jacobiano)(double,gsl_vector*,gsl_matrix*); /*!< Tipo di dato per lo jacobiano della dinamica. I parametri sono in ordine tempo,stato,calcolo della matrice jacobiana*/
+typedef double (*FunzioneEvento)(double,gsl_vector*); /*!< Tipo di dato per le funzioni degli eventi, l'evento si verifica quando il valore cambia segno. I parametri sono in ordine tempo,stato*/
+typedef void (*ODEParametri)(double,gsl_vector*,gsl_vector*,void*); /*!< Come ODE, con i dati dell'utente di InfoBaseSimulazione come ultimo parametro*/
+typedef bool (*CondizioneParametri)(double,gsl_vector*,void*); /*!< Come Condizione, con i dati dell'utente di InfoBaseSimulazione come ultimo parametro*/
+typedef void (*JacobianoParametri)(double,gsl_vector*,gsl_matrix*,void*); /*!< Come Jacobiano, con i dati dell'utente di InfoBaseSimulazione come ultimo parametro*/
+typedef double (*FunzioneEventoParametri)(double,gsl_vector*,void*); /*!< Come FunzioneEvento, con i dati dell'utente di InfoBaseSimulazione come ultimo parametro*/
+typedef void (*ODEBlocco)(double,gsl_matrix*,gsl_matrix*,void*); /*!< Tipo di dato per la dinamica di piu' stati allo stesso istante in una chiamata. I parametri sono in ordine tempo,stati per colonne,calcolo delle derivate per colonne,dati dell'utente*/
+typedef void (*Forza)(double,gsl_vector*,gsl_vector*,void*); /*!< Tipo di dato per la forza di un sistema hamiltoniano separabile H=T(p)+V(q), cioè dp/dt=-dV/dq. I parametri sono in ordine tempo,posizioni,calcolo della derivata dei momenti,dati dell'utente di InfoBaseSimulazione*/
+typedef void (*Velocita)(double,gsl_vector*,gsl_vector*,void*); /*!< Tipo di dato per la velocità di un sistema hamiltoniano separabile, cioè dq/dt=dT/dp. I parametri sono in ordine tempo,momenti,calcolo della derivata delle posizioni,dati dell'utente di InfoBaseSimulazione*/
+
+/*! \brief Metodi per risolvere l'equazione implicita dei metodi impliciti
+ */
+enum MetodoImplicito{
+  PuntoFisso, /*!< Iterazioni di punto fisso, convergono solo se h*L < 1*/
+  Newton /*!< Newton semplificato con jacobiano e fattorizzazione LU riusati tra i passi*/
+};
+
+/*! \brief Struttura dello jacobiano per il metodo di Newton
+ *
+ *  Con le strutture diverse da JacobianoDenso la memoria e il costo restano proporzionali a n e non a n^2,
+ *  lo jacobiano viene calcolato alle differenze finite perturbando insieme le colonne senza righe in comune
+ */
+enum StrutturaJacobiano{
+  JacobianoDenso, /*!< Matrice piena n x n con fattorizzazione LU*/
+  JacobianoBanda, /*!< Matrice a banda con fattorizzazione LU a banda, servono bandaInferiore+bandaSuperiore+1 valutazioni della dinamica per jacobiano*/
+  JacobianoSparso, /*!< Matrice sparsa con la struttura data in formato CSR, sistemi risolti con GMRES precondizionato con la fattorizzazione LU incompleta ILU(0)*/
+  JacobianoLibero /*!< Nessuna matrice: GMRES con il prodotto jacobiano-vettore alle differenze finite (Newton-Krylov senza jacobiano)*/
+};
+
+/*! \brief Famiglie dei metodi multipasso a passo e ordine variabili
+ */
+enum FamigliaMultipasso{
+  Adams, /*!< Adams-Moulton di ordine da 1 a 12, per problemi non rigidi*/
+  BDF, /*!< Formule di differenziazione all'indietro di ordine da 1 a 5, per problemi rigidi con il metodo di Newton*/
+  Automatica /*!< Come LSODA: Adams con iterazioni di punto fisso nei tratti non rigidi e BDF con Newton nei tratti rigidi, scelti con la stima della rigidita'*/
+};
+
+/*! \brief Metodi a passo fisso usabili come propagatori di Parareal e negli spazi di lavoro
+ */
+enum MetodoPropagatore{
+  PropagatoreEuleroAvanti, /*!< Eulero Avanti*/
+  PropagatoreEuleroIndietro, /*!< Eulero Indietro, con le impostazioni implicite di InfoBaseSimulazione*/
+  PropagatoreCrankNicolson, /*!< Crank Nicolson, con le impostazioni implicite di InfoBaseSimulazione*/
+  PropagatoreHeun, /*!< Heun*/
+  PropagatoreRungeKutta, /*!< Runge Kutta esplicito con la tabella specificata*/
+  PropagatoreRosenbrockW /*!< Rosenbrock-W ROS2, con lo jacobiano delle impostazioni implicite di InfoBaseSimulazione*/
+};
+
+/*! \brief Metodi Runge Kutta IMEX di Ascher, Ruuth e Spiteri, con il primo stadio esplicito e la stessa diagonale in tutti gli stadi impliciti
+ */
+enum MetodoIMEX{
+  ARS222, /*!< ARS(2,2,2), ordine 2 con due stadi impliciti, L-stabile*/
+  ARS443 /*!< ARS(4,4,3), ordine 3 con quattro stadi impliciti, L-stabile*/
+};
+
+/*! \brief Metodi simplettici per sistemi hamiltoniani separabili
+ *
+ *  Ogni passo alterna aggiornamenti dei momenti con la forza (kick) e delle posizioni con la velocità (drift)
+ */
+enum MetodoSimplettico{
+  StormerVerlet, /*!< Stormer-Verlet (leapfrog) nella forma kick-drift-kick, ordine 2 con una valutazione della forza per passo*/
+  Yoshida4, /*!< Composizione di Yoshida di tre passi di Stormer-Verlet, ordine 4 con tre valutazioni della forza per passo*/
+  Yoshida6, /*!< Composizione di Yoshida (soluzione A) di sette passi di Stormer-Verlet, ordine 6 con sette valutazioni della forza per passo*/
+  SimpletticoPartizionato /*!< Runge Kutta partizionato simplettico esplicito con i coefficienti specificati*/
+};
+
+/*! \brief Disposizione in memoria della matrice dei risultati
+ */
+enum Disposizione{
+  DisposizioneColonne, /*!< Matrice n x NumeroCampioni, ogni colonna è lo stato in un istante*/
+  DisposizioneRighe /*!< Matrice NumeroCampioni x n, ogni riga è lo stato in un istante ed è contigua in memoria*/
+};
+
+/*! \brief Verso di attraversamento dello zero che attiva un evento
+ */
+enum DirezioneEvento{
+  EventoEntrambe, /*!< Entrambi i versi*/
+  EventoCrescente, /*!< Solo quando la funzione passa da negativa a positiva*/
+  EventoDecrescente /*!< Solo quando la funzione passa da positiva a negativa*/
+};
+
+/*! \brief Struttura dati per un evento
+ */
+struct Evento{
+  FunzioneEvento funzione; /*!< Funzione con segno dell'evento*/
+  enum DirezioneEvento direzione; /*!< Verso di attraversamento richiesto*/
+  bool terminale; /*!< Se vero il calcolo termina all'evento, altrimenti l'evento viene solo registrato*/
+  FunzioneEventoParametri funzioneParametri; /*!< Funzione con segno dell'evento con i dati dell'utente, se specificata viene usata al posto di funzione*/
+};
+
+/*! \brief Struttura dati per impostare la ricerca degli eventi e ottenere quelli trovati
+ *
+ *  Il cambio di segno viene cercato in ogni passo sull'interpolante continua del metodo, l'istante viene localizzato con il metodo Illinois
+ */
+struct InfoEventi{
+  struct Evento* eventi; /*!< Array degli eventi*/
+  size_t numeroEventi; /*!< Numero di eventi*/
+  double tolleranza; /*!< Tolleranza sull'istante degli eventi, 0 per il valore predefinito 1e-12*(1+|t|)*/
+  size_t massimoRegistrati; /*!< Numero di elementi di istanti, indici e colonne di stati*/
+  double* istanti; /*!< Array nel quale vengono scritti gli istanti degli eventi trovati, nullptr per non specificarlo*/
+  size_t* indici; /*!< Array nel quale vengono scritti gli indici degli eventi trovati, nullptr per non specificarlo*/
+  gsl_matrix* stati; /*!< Matrice nella quale vengono scritti per colonne gli stati interpolati agli eventi, nullptr per non specificarla*/
+  size_t numeroTrovati; /*!< Numero di eventi trovati, assegnato dal metodo. Solo i primi massimoRegistrati vengono scritti*/
+  bool terminato; /*!< Vero se il calcolo e' terminato per un evento terminale, assegnato dal metodo*/
+};
+
+/*! \brief Struttura dati per impostare la soluzione delle equazioni implicite
+ */
+struct InfoImplicito{
+  enum MetodoImplicito metodo; /*!< Metodo di soluzione dell'equazione implicita*/
+  Jacobiano jacobiano; /*!< Jacobiano della dinamica, nullptr per calcolarlo alle differenze finite*/
+  double tolleranza; /*!< Tolleranza sulla norma della correzione, 0 per il valore predefinito 1e-15 per il punto fisso e 1e-10 per Newton*/
+  unsigned maxIterazioni; /*!< Numero massimo di iterazioni per passo, 0 per il valore predefinito 50*/
+  double contrazioneMax; /*!< Rapporto tra correzioni successive oltre il quale lo jacobiano viene ricalcolato, 0 per il valore predefinito 0.5*/
+  enum StrutturaJacobiano struttura; /*!< Struttura dello jacobiano, jacobiano analitico usato solo con JacobianoDenso*/
+  size_t bandaInferiore; /*!< Numero di diagonali sotto la principale con JacobianoBanda*/
+  size_t bandaSuperiore; /*!< Numero di diagonali sopra la principale con JacobianoBanda*/
+  const size_t* inizioRighe; /*!< Con JacobianoSparso, n+1 posizioni di inizio delle righe in colonne*/
+  const size_t* colonne; /*!< Con JacobianoSparso, indici di colonna dei non nulli per riga, crescenti all'interno di ogni riga*/
+  double tolleranzaKrylov; /*!< Tolleranza relativa sul residuo di GMRES, 0 per il valore predefinito 1e-6*/
+  unsigned dimensioneKrylov; /*!< Dimensione della base di Krylov prima del riavvio di GMRES, 0 per il valore predefinito 30*/
+  JacobianoParametri jacobianoParametri; /*!< Jacobiano della dinamica con i dati dell'utente, se specificato viene usato al posto di jacobiano*/
+};
+
+/*! \brief Statistiche di un calcolo, azzerate e compilate dal metodo
+ *
+ *  I tempi vengono misurati solo se le statistiche sono richieste, la differenza tra tempoTotale e tempoDinamica e' il tempo passato nella libreria
+ */
+struct Statistiche{
+  size_t passi; /*!< Passi accettati*/
+  size_t passiRifiutati; /*!< Passi rifiutati dal controllo dell'errore dei metodi adattivi*/
+  size_t chiamateDinamica; /*!< Valutazioni della dinamica, negli insiemi una per membro*/
+  size_t iterazioni; /*!< Iterazioni per le equazioni implicite*/
+  size_t passiNonConvergenti; /*!< Equazioni implicite che non hanno raggiunto la tolleranza entro maxIterazioni*/
+  size_t jacobiani; /*!< Valutazioni dello jacobiano, analitico o alle differenze finite*/
+  size_t fattorizzazioni; /*!< Fattorizzazioni LU della matrice di iterazione*/
+  size_t iterazioniLineari; /*!< Iterazioni di GMRES per i sistemi lineari con JacobianoSparso e JacobianoLibero*/
+  double tempoDinamica; /*!< Secondi passati nella dinamica, negli insiemi sommati su tutti i thread*/
+  double tempoTotale; /*!< Secondi totali del calcolo*/
+};
 
 /*! \brief Struttura dati per impostare il calcolo della soluzione numerica
+ *
+ *  Lo stato di ogni calcolo e' locale alla chiamata del metodo, quindi calcoli diversi possono essere eseguiti contemporaneamente su thread diversi
+ *  purche' non condividano le strutture scritte dal metodo (statistiche, eventi, uscita). Con le funzioni con parametri i dati del modello
+ *  possono essere diversi per ogni calcolo senza variabili globali
  */
 struct InfoBaseSimulazione{
-  ODE dinamica; /*!< Dinamica da integrare*/
+  ODE dinamica; /*!< Dinamica da integrare, nullptr se si specifica dinamicaParametri*/
   Condizione condizione; /*!< Condizione di uscita, nullptr per non specificarla*/
   double *tCondizione; /*!< Indirizzo a una variabile per ottenere l'istante di uscita, nullptr per non specificarla*/
   size_t *indiceCondizione; /*!< Indirizzo a una variabile per ottenere l'indice di uscita, nullptr per non specificarla */
-  double t0 /*!< Istante iniziale del calcolo*/
-  double T /*!< Periodo di integrazione*/
+  double t0; /*!< Istante iniziale del calcolo*/
+  double T; /*!< Periodo di integrazione*/
   double h; /*!< Passo di integrazione*/
+  struct InfoImplicito* implicito; /*!< Impostazioni per i metodi impliciti, nullptr per le iterazioni di punto fisso predefinite*/
+  enum Disposizione disposizione; /*!< Disposizione della matrice dei risultati*/
+  struct InfoEventi* eventi; /*!< Eventi da localizzare all'interno dei passi, nullptr per non specificarli. Con un evento terminale tCondizione e' l'istante dell'evento e indiceCondizione il primo stato successivo*/
+  struct Statistiche* statistiche; /*!< Indirizzo nel quale scrivere le statistiche del calcolo, nullptr per non specificarlo*/
+  ODEParametri dinamicaParametri; /*!< Dinamica con i dati dell'utente, se specificata viene usata al posto di dinamica*/
+  CondizioneParametri condizioneParametri; /*!< Condizione di uscita con i dati dell'utente, se specificata viene usata al posto di condizione*/
+  ODEBlocco dinamicaBlocco; /*!< Dinamica di piu' stati allo stesso istante in una chiamata, usata per lo jacobiano alle differenze finite e per gli insiemi. nullptr per chiamare la dinamica per ogni stato*/
+  void* parametri; /*!< Dati dell'utente passati alle funzioni con parametri e a dinamicaBlocco*/
+};
+
+/*! \brief Scrittore di un file di traiettoria a blocchi
+ *
+ *  Il file ha un'intestazione fissa con versione, seguita dai record [t, x_0, ..., x_{n-1}] contigui in ordine di tempo e dall'indice dei blocchi.
+ *  I record vengono scritti un blocco alla volta e l'intestazione aggiornata dopo ogni blocco, quindi un file interrotto resta leggibile fino all'ultimo blocco completo
+ */
+struct ScrittoreTraiettoria;
+
+/*! \brief Elemento dell'indice dei blocchi di un file di traiettoria
+ */
+struct BloccoTraiettoria{
+  uint64_t posizione; /*!< Posizione del blocco nel file in byte*/
+  uint64_t primoRecord; /*!< Indice del primo record del blocco*/
+  uint64_t numeroRecord; /*!< Numero di record del blocco*/
+  double tInizio; /*!< Istante del primo record*/
+  double tFine; /*!< Istante dell'ultimo record*/
+};
+
+/*! \brief Lettore di un file di traiettoria mappato in memoria
+ *
+ *  I campi vanno solo letti, le viste restituite da TraiettoriaStati, TraiettoriaIstanti e TraiettoriaComponente puntano direttamente al file e restano valide fino a TraiettoriaLibera
+ */
+struct LettoreTraiettoria{
+  size_t n; /*!< Dimensione dello stato*/
+  size_t numeroRecord; /*!< Numero di record nel file*/
+  const double* record; /*!< Primo record, ogni record e' composto da n+1 double*/
+  const struct BloccoTraiettoria* blocchi; /*!< Indice dei blocchi, nullptr se il file non e' stato chiuso correttamente*/
+  size_t numeroBlocchi; /*!< Numero di elementi dell'indice*/
+  void* mappa; /*!< Indirizzo della mappatura del file*/
+  size_t dimensioneMappa; /*!< Dimensione della mappatura in byte*/
+};
+
+/*! \brief Struttura dati per impostare l'uscita dei metodi in flusso
+ *
+ *  Gli stati vengono passati all'uscita man mano che sono calcolati, senza memorizzare la traiettoria
+ */
+struct InfoUscita{
+  FunzioneUscita funzione; /*!< Funzione chiamata per ogni stato emesso, nullptr per non specificarla*/
+  void* dati; /*!< Indirizzo passato alla funzione di uscita*/
+  FILE* file; /*!< File binario nel quale scrivere gli stati, con la stessa intestazione di fwrite_risultato e disposizione per righe. nullptr per non specificarlo*/
+  size_t decimazione; /*!< Emette uno stato ogni decimazione passi, 0 o 1 per emetterli tutti*/
+  const double* istanti; /*!< Istanti richiesti in ordine crescente, viene emesso il primo stato calcolato a partire da ciascuno. nullptr per usare la decimazione*/
+  size_t numeroIstanti; /*!< Numero di istanti richiesti*/
+  size_t emessi; /*!< Numero di stati emessi, assegnato dal metodo*/
+  struct ScrittoreTraiettoria* traiettoria; /*!< File di traiettoria al quale aggiungere gli stati emessi, nullptr per non specificarlo. Il file non viene chiuso dal metodo*/
+};
+
+/*! \brief Struttura dati per impostare il calcolo di un insieme di traiettorie
+ */
+struct InfoInsieme{
+  ODEInsieme dinamica; /*!< Dinamica valutata su un blocco di membri in una sola chiamata, nullptr per chiamare la dinamica di InfoBaseSimulazione per ogni membro*/
+  unsigned numeroThread; /*!< Numero di thread usati per il calcolo, 0 o 1 per usare solo il thread chiamante*/
+  size_t dimensioneBlocco; /*!< Numero di membri integrati insieme da un thread, 0 per il valore predefinito 64*/
+  double* tCondizione; /*!< Array con un elemento per membro per ottenere l'istante di uscita, nullptr per non specificarlo*/
+  size_t* indiceCondizione; /*!< Array con un elemento per membro per ottenere l'indice di uscita, nullptr per non specificarlo*/
+};
+
+/*! \brief Struttura dati per impostare il controllo del passo dei metodi adattivi
+ */
+struct InfoAdattivo{
+  double tolleranzaAssoluta; /*!< Tolleranza assoluta sull'errore locale. Con 0 le componenti che restano nulle devono avere errore nullo, altrimenti il passo viene rifiutato*/
+  double tolleranzaRelativa; /*!< Tolleranza relativa sull'errore locale*/
+  unsigned ordine; /*!< Ordine della soluzione incorporata di ordine minore, usato dal controllore del passo. Va specificato, ad esempio 4 per Dormand-Prince e 2 per Bogacki-Shampine; con 0 si usa 1*/
+  double hMin; /*!< Passo minimo, sotto il quale il calcolo termina. 0 per non specificarlo*/
+  double hMax; /*!< Passo massimo, 0 per usare il periodo di integrazione*/
+  double sicurezza; /*!< Fattore di sicurezza del controllore, 0 per il valore predefinito 0.9*/
+  double beta; /*!< Guadagno integrale del controllore PI, 0 per il valore predefinito 0.04*/
+  size_t maxPassi; /*!< Numero massimo di passi tentati, 0 per non specificarlo*/
+  const double* densa; /*!< Coefficienti d_j dell'uscita densa di quarto grado, uno per stadio, usati per localizzare gli eventi, ad esempio DormandPrince_D. nullptr per l'interpolante di Hermite cubica*/
+};
+
+/*! \brief Cambio di famiglia di un metodo multipasso con famiglia Automatica
+ */
+struct CambioFamiglia{
+  double t; /*!< Istante dell'ultimo passo accettato con la famiglia precedente*/
+  size_t passo; /*!< Indice dello stato corrispondente*/
+  enum FamigliaMultipasso famiglia; /*!< Famiglia usata dopo il cambio, Adams o BDF*/
+  double h; /*!< Passo al momento del cambio*/
+  double rigidita; /*!< Stima di h*el_0*rho che ha causato il cambio, con rho raggio spettrale dello jacobiano: oltre la soglia il punto fisso di Adams non converge, sotto la soglia Adams converge con lo stesso passo di BDF*/
+};
+
+/*! \brief Struttura dati per impostare i metodi multipasso a passo e ordine variabili
+ */
+struct InfoMultipasso{
+  enum FamigliaMultipasso famiglia; /*!< Famiglia del metodo*/
+  double tolleranzaAssoluta; /*!< Tolleranza assoluta sull'errore locale*/
+  double tolleranzaRelativa; /*!< Tolleranza relativa sull'errore locale*/
+  unsigned ordineMax; /*!< Ordine massimo, 0 per il massimo della famiglia*/
+  double hMin; /*!< Passo minimo, sotto il quale il calcolo termina. 0 per non specificarlo*/
+  double hMax; /*!< Passo massimo, 0 per usare il periodo di integrazione*/
+  size_t maxPassi; /*!< Numero massimo di passi tentati, 0 per non specificarlo*/
+  struct CambioFamiglia* cambi; /*!< Array nel quale vengono registrati i cambi di famiglia con Automatica, nullptr per non specificarlo*/
+  size_t massimoCambi; /*!< Numero di elementi di cambi*/
+  size_t numeroCambi; /*!< Numero di cambi di famiglia, assegnato dal metodo. Solo i primi massimoCambi vengono registrati*/
+};
+
+/*! \brief Propagatore a passo fisso su un intervallo di tempo
+ */
+struct Propagatore{
+  enum MetodoPropagatore metodo; /*!< Metodo del propagatore*/
+  double* A_Butcher; /*!< Coefficienti di Butcher per PropagatoreRungeKutta, memorizzati in ordine prima le righe*/
+  double* B_Butcher; /*!< Pesi di Butcher per PropagatoreRungeKutta*/
+  unsigned stadi; /*!< Numero di stadi per PropagatoreRungeKutta*/
+};
+
+/*! \brief Spazio di lavoro per ripetere un metodo a passo fisso senza allocazioni
+ *
+ *  Contiene la matrice dei risultati, i buffer degli stadi, i coefficienti c_j della tabella di Butcher e il risolutore implicito,
+ *  allocati una volta per metodo, dimensione dello stato e numero di campioni
+ */
+struct SpazioLavoro;
+
+/*! \brief Struttura dati per impostare il calcolo parallelo nel tempo con Parareal
+ */
+struct InfoParareal{
+  struct Propagatore grossolano; /*!< Propagatore economico eseguito in serie*/
+  struct Propagatore fine; /*!< Propagatore accurato eseguito in parallelo su tutti gli intervalli, con il passo h di InfoBaseSimulazione*/
+  double hGrossolano; /*!< Passo del propagatore grossolano, 0 per un solo passo per intervallo*/
+  size_t intervalli; /*!< Numero di intervalli in cui viene diviso il periodo di integrazione, 0 per usarne uno per thread*/
+  unsigned numeroThread; /*!< Numero di thread usati per il propagatore fine, 0 o 1 per usare solo il thread chiamante*/
+  double tolleranza; /*!< Tolleranza sulla correzione massima tra due iterazioni, relativa a 1+|x|. 0 per il valore predefinito 1e-10*/
+  unsigned maxIterazioni; /*!< Numero massimo di iterazioni, 0 per il numero di intervalli oltre il quale il risultato coincide con quello del propagatore fine*/
+  unsigned iterazioni; /*!< Numero di iterazioni eseguite, assegnato dal metodo*/
+  double correzione; /*!< Correzione dell'ultima iterazione, assegnata dal metodo*/
+};
+
+/*! \brief Struttura dati per impostare i metodi IMEX
+ *
+ *  La dinamica di InfoBaseSimulazione e' la parte non rigida f_E, integrata esplicitamente; la parte rigida f_I viene integrata implicitamente.
+ *  Con L la matrice I-gamma*h*L viene fattorizzata una volta per calcolo, con rigida le equazioni degli stadi vengono risolte con le impostazioni implicite di InfoBaseSimulazione,
+ *  e lo jacobiano eventualmente specificato e' quello della parte rigida
+ */
+struct InfoIMEX{
+  enum MetodoIMEX metodo; /*!< Metodo di integrazione*/
+  const gsl_matrix* L; /*!< Parte rigida lineare f_I(t,y)=L*y, nullptr per usare rigida*/
+  ODEParametri rigida; /*!< Parte rigida non lineare f_I(t,y) con i dati dell'utente di InfoBaseSimulazione, usata se L e' nullptr*/
 };
 
+/*! \brief Struttura dati per impostare i metodi simplettici
+ *
+ *  Lo stato e' [q, p]: le prime n/2 componenti sono le posizioni e le ultime n/2 i momenti.
+ *  Con SimpletticoPartizionato lo stadio i esegue p += b_i*h*F(q) e poi q += a_i*h*v(p); se l'ultimo a_i e' nullo la forza finale viene riusata nel passo successivo
+ */
+struct InfoSimplettico{
+  enum MetodoSimplettico metodo; /*!< Metodo di integrazione*/
+  Forza forza; /*!< Forza -dV/dq in funzione delle posizioni*/
+  Velocita velocita; /*!< Velocità dT/dp in funzione dei momenti, nullptr per T(p)=|p|^2/2 cioè dq/dt=p*/
+  const double* a; /*!< Coefficienti degli aggiornamenti delle posizioni per SimpletticoPartizionato*/
+  const double* b; /*!< Coefficienti degli aggiornamenti dei momenti per SimpletticoPartizionato*/
+  unsigned stadi; /*!< Numero di stadi per SimpletticoPartizionato*/
+};
+
+extern const double DormandPrince_A[49]; /*!< Tabella di Butcher di Dormand-Prince 5(4), 7 stadi con proprietà FSAL*/
+extern const double DormandPrince_B[7]; /*!< Pesi di ordine 5 di Dormand-Prince*/
+extern const double DormandPrince_Bcappello[7]; /*!< Pesi incorporati di ordine 4 di Dormand-Prince*/
+extern const double DormandPrince_D[7]; /*!< Coefficienti dell'uscita densa di Dormand-Prince (Hairer, Norsett, Wanner), da usare in InfoAdattivo::densa*/
+extern const double Fehlberg_A[36]; /*!< Tabella di Butcher di Runge-Kutta-Fehlberg 4(5), 6 stadi*/
+extern const double Fehlberg_B[6]; /*!< Pesi di ordine 5 di Fehlberg*/
+extern const double Fehlberg_Bcappello[6]; /*!< Pesi incorporati di ordine 4 di Fehlberg*/
+extern const double BogackiShampine_A[16]; /*!< Tabella di Butcher di Bogacki-Shampine 3(2), 4 stadi con proprietà FSAL*/
+extern const double BogackiShampine_B[4]; /*!< Pesi di ordine 3 di Bogacki-Shampine*/
+extern const double BogackiShampine_Bcappello[4]; /*!< Pesi incorporati di ordine 2 di Bogacki-Shampine*/
+
 /*! \fn gsl_matrix* EuleroAvanti(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale)
  *  \brief Metodo di integrazione Eulero Avanti
  *
@@ -64,6 +384,28 @@ struct InfoBaseSimulazione{
  *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico, la matrice deve essere deallocata dall'utente
  */
  
+/*! \fn gsl_matrix* RosenbrockW(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale)
+ *  \brief Metodo di integrazione Rosenbrock-W ROS2 di Verwer, linearmente implicito di ordine 2 e L-stabile con gamma=1+1/sqrt(2)
+ *
+ *  A ogni passo lo jacobiano viene calcolato e I-gamma*h*J fattorizzata una sola volta per i due stadi, senza iterazioni di Newton.
+ *  L'ordine non dipende dall'esattezza dello jacobiano, quindi si possono usare tutte le strutture di InfoImplicito, anche JacobianoLibero. Il campo metodo di InfoImplicito non viene usato.
+ *  La derivata della dinamica rispetto al tempo non viene usata, quindi per problemi rigidi non autonomi conviene aggiungere il tempo allo stato
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo
+ *  \param statoIniziale Vettore per lo stato iniziale del calcolo
+ *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico, la matrice deve essere deallocata dall'utente
+ */
+ 
+/*! \fn gsl_matrix* RungeKuttaIMEX(struct InfoBaseSimulazione* infoSimulazione,struct InfoIMEX* infoIMEX,gsl_vector* statoIniziale)
+ *  \brief Metodo di integrazione Runge Kutta IMEX per y' = f_E(t,y) + f_I(t,y) con f_E non rigida e f_I rigida
+ *
+ *  Gli stadi impliciti sono y_i = r_i + gamma*h*f_I(t_i,y_i), con r_i che dipende solo dagli stadi precedenti; f_E viene valutata solo negli stadi.
+ *  Gli eventi usano la dinamica completa f_E+f_I agli estremi del passo, valutata a ogni passo solo se sono richiesti
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo, la dinamica e' la parte non rigida
+ *  \param infoIMEX Indirizzo alla struttura dati per impostare metodo e parte rigida
+ *  \param statoIniziale Vettore per lo stato iniziale del calcolo
+ *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico, la matrice deve essere deallocata dall'utente
+ */
+ 
 /*! \fn gsl_matrix* LMM(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco)
  *  \brief Metodo di integrazione LMM
  *
@@ -71,10 +413,162 @@ struct InfoBaseSimulazione{
  *  \param A_LMM Coefficienti sulla soluzione numerica
  *  \param B_LMM Coefficienti sulla dinamica
  *  \param b_1 Coefficiente per metodi impliciti
- *  \param innesco Matrice per innesco del metodo
+ *  \param innesco Matrice per innesco del metodo, ogni colonna è uno stato indipendentemente dalla disposizione dei risultati
  *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico, la matrice deve essere deallocata dall'utente
  */
  
+/*! \fn gsl_matrix* RungeKuttaAdattivo(struct InfoBaseSimulazione* infoSimulazione,struct InfoAdattivo* infoAdattivo,const double* A_Butcher,const double* B_Butcher,const double* Bcappello_Butcher,const unsigned stadi,gsl_vector* statoIniziale,gsl_vector** istanti)
+ *  \brief Metodo di integrazione Runge Kutta esplicito a passo adattivo con tabella incorporata
+ *
+ *  Il passo viene scelto con un controllore PI sulla stima dell'errore locale, se l'ultimo stadio coincide con la soluzione (FSAL) viene riusato come primo stadio del passo successivo.
+ *  Gli eventi vengono localizzati con l'interpolante di Hermite cubica, con la correzione di quarto grado sum_j h*d_j*K_j se infoAdattivo->densa specifica i coefficienti d_j.
+ *  La correzione dipende solo da densa e non dalla tabella, quindi con Dormand-Prince va specificato DormandPrince_D anche con una copia di DormandPrince_A.
+ *  Il campo h di infoSimulazione è il passo iniziale, con h <= 0 viene stimato automaticamente.
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo
+ *  \param infoAdattivo Indirizzo alla struttura dati per impostare il controllo del passo
+ *  \param A_Butcher Array dei coefficienti di Butcher, devono essere memorizzate in ordine prima le righe
+ *  \param B_Butcher Array dei pesi della soluzione propagata
+ *  \param Bcappello_Butcher Array dei pesi della soluzione incorporata per la stima dell'errore
+ *  \param stadi Numero di stadi del metodo
+ *  \param statoIniziale Vettore per lo stato iniziale del calcolo
+ *  \param istanti Indirizzo nel quale viene allocato il vettore degli istanti accettati, nullptr per non specificarlo. Il vettore deve essere deallocato dall'utente
+ *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico negli istanti accettati, la matrice deve essere deallocata dall'utente
+ */
+ 
+/*! \fn gsl_matrix* MultipassoAdattivo(struct InfoBaseSimulazione* infoSimulazione,struct InfoMultipasso* infoMultipasso,gsl_vector* statoIniziale,gsl_vector** istanti)
+ *  \brief Metodo multipasso Adams o BDF a passo e ordine variabili, sulla falsariga di LSODE
+ *
+ *  La storia e' memorizzata in forma di Nordsieck, quindi passo e ordine cambiano riscalandola senza ricalcolare stati precedenti.
+ *  Il metodo parte da solo all'ordine 1 e sceglie ordine e passo con la stima dell'errore locale. Il correttore usa il metodo di infoSimulazione->implicito, con al massimo 4 iterazioni se non specificato.
+ *  La convergenza del correttore e' misurata nella norma pesata con le tolleranze del test sull'errore, quindi la tolleranza di infoSimulazione->implicito e' relativa a questa norma
+ *  e vale 0.01 se non specificata. Il calcolo termina dopo 10 fallimenti consecutivi del correttore, quando il passo scende sotto hMin o non cambia piu' l'istante.
+ *  Con la famiglia Automatica il calcolo parte con Adams e punto fisso; la rigidita' h*el_0*rho viene stimata dal rapporto tra le correzioni del punto fisso con Adams
+ *  e dalla norma dello jacobiano con BDF, e la famiglia cambia quando la stima resta oltre o sotto la soglia per diversi passi. La storia di Nordsieck viene mantenuta nel cambio,
+ *  con l'ordine limitato a 5 per BDF. Con JacobianoLibero la norma dello jacobiano non e' disponibile e il calcolo resta con BDF.
+ *  Il campo h di infoSimulazione è il passo iniziale, con h <= 0 viene stimato automaticamente.
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo
+ *  \param infoMultipasso Indirizzo alla struttura dati per impostare famiglia, ordine e controllo del passo
+ *  \param statoIniziale Vettore per lo stato iniziale del calcolo
+ *  \param istanti Indirizzo nel quale viene allocato il vettore degli istanti accettati, nullptr per non specificarlo. Il vettore deve essere deallocato dall'utente
+ *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico negli istanti accettati, la matrice deve essere deallocata dall'utente
+ */
+ 
+/*! \fn gsl_matrix* Parareal(struct InfoBaseSimulazione* infoSimulazione,struct InfoParareal* infoParareal,gsl_vector* statoIniziale)
+ *  \brief Integrazione parallela nel tempo con l'algoritmo Parareal
+ *
+ *  Il periodo di integrazione viene diviso in intervalli. A ogni iterazione il propagatore fine viene eseguito in parallelo su tutti gli intervalli non ancora esatti,
+ *  poi il propagatore grossolano corregge in serie gli stati ai bordi: x_{j+1} = G(x_j) + F(x_j^precedente) - G(x_j^precedente).
+ *  Dopo k iterazioni i primi k intervalli coincidono con il propagatore fine, il calcolo termina quando la correzione scende sotto la tolleranza.
+ *  La dinamica viene chiamata da piu' thread contemporaneamente e deve quindi essere rientrante. Condizione ed eventi non vengono considerati.
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo, h e' il passo del propagatore fine
+ *  \param infoParareal Indirizzo alla struttura dati per impostare propagatori, intervalli e convergenza
+ *  \param statoIniziale Vettore per lo stato iniziale del calcolo
+ *  \return La funzione alloca una matrice gsl_matrix che contiene gli stati ai bordi degli intervalli, la matrice deve essere deallocata dall'utente
+ */
+ 
+/*! \fn struct SpazioLavoro* SpazioLavoroAlloca(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,size_t n)
+ *  \brief Alloca uno spazio di lavoro per ripetere il calcolo di un metodo a passo fisso
+ *
+ *  Le impostazioni implicite, la disposizione e il numero massimo di campioni floor(T/h)+1 sono quelli di infoSimulazione. La tabella di Butcher non viene copiata e deve restare valida
+ *  \param infoSimulazione Indirizzo alla struttura dati con le impostazioni dei calcoli
+ *  \param propagatore Metodo a passo fisso
+ *  \param n Dimensione dello stato
+ *  \return Lo spazio di lavoro da deallocare con SpazioLavoroLibera
+ */
+
+/*! \fn gsl_matrix* IntegraSpazioLavoro(struct SpazioLavoro* spazio,struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale)
+ *  \brief Calcolo a passo fisso nello spazio di lavoro, senza allocazioni se non sono richiesti eventi
+ *
+ *  Dinamica, istanti, passo e parametri possono cambiare tra un calcolo e l'altro purche' il numero di campioni non superi quello dello spazio di lavoro.
+ *  Lo jacobiano non viene riusato tra i calcoli, quindi il risultato coincide con quello del metodo corrispondente. Uno spazio di lavoro non puo' essere usato da piu' thread contemporaneamente
+ *  \param spazio Spazio di lavoro restituito da SpazioLavoroAlloca
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo
+ *  \param statoIniziale Vettore per lo stato iniziale del calcolo
+ *  \return Vista sulla matrice dei risultati dello spazio di lavoro, valida fino al calcolo successivo. Gli stati oltre indiceCondizione non vengono azzerati. nullptr se dimensione, campioni o disposizione non sono compatibili
+ */
+ 
+/*! \fn gsl_matrix* Simplettico(struct InfoBaseSimulazione* infoSimulazione,struct InfoSimplettico* infoSimplettico,gsl_vector* statoIniziale)
+ *  \brief Metodo simplettico a passo fisso per sistemi hamiltoniani separabili
+ *
+ *  Il metodo conserva la struttura simplettica, quindi su tempi lunghi l'errore sull'energia resta limitato invece di crescere come nei metodi Runge Kutta.
+ *  La dinamica di infoSimulazione non viene usata: forza e velocità ricevono i parametri di infoSimulazione e chiamateDinamica nelle statistiche conta le valutazioni della forza.
+ *  Condizione ed eventi sono gestiti come negli altri metodi a passo fisso, per gli eventi l'interpolante usa forza e velocità agli estremi del passo
+ *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo
+ *  \param infoSimplettico Indirizzo alla struttura dati per impostare metodo, forza e velocità
+ *  \param statoIniziale Vettore per lo stato iniziale [q, p] del calcolo, di dimensione pari
+ *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico, la matrice deve essere deallocata dall'utente
+ */
+ 
+/*! \fn int InterpolaRisultato(struct InfoBaseSimulazione* infoSimulazione,gsl_matrix* O_sim,const gsl_vector* istanti,double t,gsl_vector* stato)
+ *  \brief Uscita continua: calcola lo stato in un istante qualsiasi tra due stati del risultato
+ *
+ *  Usa l'interpolante di Hermite cubica costruita sugli stati e sulla dinamica agli estremi del passo, con ordine 3 indipendentemente dal metodo.
+ *  La dinamica di infoSimulazione deve essere il secondo membro completo: per i risultati di Simplettico va specificata [v(p), F(q)],
+ *  per quelli di RungeKuttaIMEX la somma f_E+f_I della parte esplicita e di quella rigida
+ *  \param infoSimulazione Indirizzo alla struttura dati usata per il calcolo, con dinamica o dinamicaParametri
+ *  \param O_sim Matrice dei risultati, con la disposizione di infoSimulazione
+ *  \param istanti Istanti degli stati restituiti dai metodi adattivi, nullptr per la griglia a passo fisso
+ *  \param t Istante richiesto, non successivo all'ultimo stato calcolato
+ *  \param stato Vettore nel quale viene scritto lo stato interpolato
+ *  \return 0 se l'istante e' all'interno del risultato, 1 altrimenti, 2 se infoSimulazione non specifica la dinamica
+ */
+
+/*! \fn struct ScrittoreTraiettoria* TraiettoriaApri(const char* percorso,size_t n,size_t recordPerBlocco,bool aggiungi)
+ *  \brief Apre un file di traiettoria per la scrittura
+ *
+ *  \param percorso Percorso del file
+ *  \param n Dimensione dello stato
+ *  \param recordPerBlocco Numero di record di ogni blocco, 0 per il valore predefinito 4096
+ *  \param aggiungi Se vero e il file esiste i nuovi record vengono aggiunti a quelli presenti, altrimenti il file viene riscritto
+ *  \return Lo scrittore da chiudere con TraiettoriaChiudi, nullptr se il file non puo' essere aperto o non e' compatibile
+ */
+
+/*! \fn int TraiettoriaScrivi(struct ScrittoreTraiettoria* scrittore,double t,const gsl_vector* stato)
+ *  \brief Aggiunge un record al file di traiettoria
+ *
+ *  \param scrittore Scrittore restituito da TraiettoriaApri
+ *  \param t Istante dello stato
+ *  \param stato Stato da scrivere
+ *  \return 0 se la scrittura e' riuscita, 1 altrimenti
+ */
+
+/*! \fn int TraiettoriaChiudi(struct ScrittoreTraiettoria* scrittore)
+ *  \brief Scrive l'ultimo blocco e l'indice, poi chiude il file e dealloca lo scrittore
+ *
+ *  \return 0 se la scrittura e' riuscita, 1 altrimenti
+ */
+
+/*! \fn struct LettoreTraiettoria* TraiettoriaLeggi(const char* percorso)
+ *  \brief Mappa in memoria un file di traiettoria in sola lettura
+ *
+ *  \param percorso Percorso del file
+ *  \return Il lettore da deallocare con TraiettoriaLibera, nullptr se il file non esiste o non e' valido
+ */
+
+/*! \fn void TraiettoriaLibera(struct LettoreTraiettoria* lettore)
+ *  \brief Rimuove la mappatura del file e dealloca il lettore
+ */
+
+/*! \fn gsl_matrix_const_view TraiettoriaStati(const struct LettoreTraiettoria* lettore,size_t primo,size_t numero)
+ *  \brief Vista senza copia sugli stati di un intervallo di record
+ *
+ *  \return Matrice numero x n, ogni riga e' uno stato come con DisposizioneRighe
+ */
+
+/*! \fn gsl_vector_const_view TraiettoriaIstanti(const struct LettoreTraiettoria* lettore,size_t primo,size_t numero)
+ *  \brief Vista senza copia sugli istanti di un intervallo di record
+ */
+
+/*! \fn gsl_vector_const_view TraiettoriaComponente(const struct LettoreTraiettoria* lettore,size_t componente,size_t primo,size_t numero)
+ *  \brief Vista senza copia su una componente dello stato in un intervallo di record
+ */
+
+/*! \fn size_t TraiettoriaCerca(const struct LettoreTraiettoria* lettore,double t)
+ *  \brief Indice del primo record con istante non precedente a t, con istanti crescenti
+ *
+ *  \return L'indice del record, numeroRecord se tutti gli istanti sono precedenti a t
+ */
+
 /*! \fn int fwrite_matrix(FILE* file, gsl_matrix* matrice,double h, double T, double t0)
  *  \brief Funzione per scrivere in formato binario il risultato del calcolo
  *
@@ -84,10 +578,58 @@ struct InfoBaseSimulazione{
  *  \param T Periodo di integrazione
  *  \param t0 Istante iniziale del calcolo
  */
+ 
+/*! \fn int fwrite_risultato(FILE* file, gsl_matrix* matrice,enum Disposizione disposizione,double h, double T, double t0)
+ *  \brief Funzione per scrivere in formato binario il risultato del calcolo con la disposizione specificata
+ *
+ *  L'intestazione riporta sempre la dimensione dello stato e il numero di passi, insieme alla disposizione dei dati che seguono
+ *  \param file File nel quale scrivere il risultato
+ *  \param matrice Matrice che contiene il risultato numerico
+ *  \param disposizione Disposizione della matrice
+ *  \param h Passo di integrazione
+ *  \param T Periodo di integrazione
+ *  \param t0 Istante iniziale del calcolo
+ */
 gsl_matrix* EuleroAvanti(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale);
 gsl_matrix* EuleroIndietro(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale);
 gsl_matrix* CrankNicolson(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale);
 gsl_matrix* Heun(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale);
 gsl_matrix* RungeKuttaEsplicito(struct InfoBaseSimulazione* infoSimulazione,double* A_Butcher, double* B_Butcher,const unsigned stadi,gsl_vector* statoIniziale);
+gsl_matrix* RosenbrockW(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale);
+gsl_matrix* RungeKuttaIMEX(struct InfoBaseSimulazione* infoSimulazione,struct InfoIMEX* infoIMEX,gsl_vector* statoIniziale);
 gsl_matrix* LMM(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco);
+gsl_matrix* RungeKuttaAdattivo(struct InfoBaseSimulazione* infoSimulazione,struct InfoAdattivo* infoAdattivo,const double* A_Butcher,const double* B_Butcher,const double* Bcappello_Butcher,const unsigned stadi,gsl_vector* statoIniziale,gsl_vector** istanti);
+gsl_matrix* MultipassoAdattivo(struct InfoBaseSimulazione* infoSimulazione,struct InfoMultipasso* infoMultipasso,gsl_vector* statoIniziale,gsl_vector** istanti);
+int EuleroAvantiFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int EuleroIndietroFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int CrankNicolsonFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int HeunFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int RungeKuttaEsplicitoFlusso(struct InfoBaseSimulazione* infoSimulazione,double* A_Butcher, double* B_Butcher,const unsigned stadi,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int RosenbrockWFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int RungeKuttaIMEXFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoIMEX* infoIMEX,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int LMMFlusso(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco,struct InfoUscita* uscita);
+int RungeKuttaAdattivoFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoAdattivo* infoAdattivo,const double* A_Butcher,const double* B_Butcher,const double* Bcappello_Butcher,const unsigned stadi,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int MultipassoAdattivoFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoMultipasso* infoMultipasso,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+gsl_matrix** RungeKuttaEsplicitoInsieme(struct InfoBaseSimulazione* infoSimulazione,struct InfoInsieme* infoInsieme,const double* A_Butcher,const double* B_Butcher,const unsigned stadi,gsl_matrix* statiIniziali);
+gsl_matrix** HeunInsieme(struct InfoBaseSimulazione* infoSimulazione,struct InfoInsieme* infoInsieme,gsl_matrix* statiIniziali);
+void LiberaInsieme(gsl_matrix** O_sim,size_t membri);
+gsl_matrix* Parareal(struct InfoBaseSimulazione* infoSimulazione,struct InfoParareal* infoParareal,gsl_vector* statoIniziale);
+struct SpazioLavoro* SpazioLavoroAlloca(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,size_t n);
+gsl_matrix* IntegraSpazioLavoro(struct SpazioLavoro* spazio,struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale);
+void SpazioLavoroLibera(struct SpazioLavoro* spazio);
+gsl_matrix* Simplettico(struct InfoBaseSimulazione* infoSimulazione,struct InfoSimplettico* infoSimplettico,gsl_vector* statoIniziale);
+int SimpletticoFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoSimplettico* infoSimplettico,gsl_vector* statoIniziale,struct InfoUscita* uscita);
+int InterpolaRisultato(struct InfoBaseSimulazione* infoSimulazione,gsl_matrix* O_sim,const gsl_vector* istanti,double t,gsl_vector* stato);
+struct ScrittoreTraiettoria* TraiettoriaApri(const char* percorso,size_t n,size_t recordPerBlocco,bool aggiungi);
+int TraiettoriaScrivi(struct ScrittoreTraiettoria* scrittore,double t,const gsl_vector* stato);
+int TraiettoriaChiudi(struct ScrittoreTraiettoria* scrittore);
+struct LettoreTraiettoria* TraiettoriaLeggi(const char* percorso);
+void TraiettoriaLibera(struct LettoreTraiettoria* lettore);
+gsl_matrix_const_view TraiettoriaStati(const struct LettoreTraiettoria* lettore,size_t primo,size_t numero);
+gsl_vector_const_view TraiettoriaIstanti(const struct LettoreTraiettoria* lettore,size_t primo,size_t numero);
+gsl_vector_const_view TraiettoriaComponente(const struct LettoreTraiettoria* lettore,size_t componente,size_t primo,size_t numero);
+size_t TraiettoriaCerca(const struct LettoreTraiettoria* lettore,double t);
 int fwrite_matrix(FILE* file, gsl_matrix* matrice,double h, double T, double t0);
+int fwrite_risultato(FILE* file, gsl_matrix* matrice,enum Disposizione disposizione,double h, double T, double t0);
+
+#endif
@@ -0,0 +1,247 @@
+/*! \file ode_specializzato.hpp
+ *  \brief File header per i metodi Runge Kutta specializzati a tempo di compilazione
+ *
+ *  La dimensione dello stato e la tabella di Butcher sono parametri template, i cicli sugli stadi vengono espansi e i coefficienti nulli eliminati dal compilatore
+ */
+#ifndef ODE_SPECIALIZZATO_HPP
+#define ODE_SPECIALIZZATO_HPP
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <ode.h>
+
+namespace ode{
+
+/*! \brief Tabella di Butcher di Eulero Avanti
+ */
+struct TabellaEulero{
+  static constexpr std::size_t stadi=1;
+  static constexpr double A[1][1]={{0.0}};
+  static constexpr double B[1]={1.0};
+};
+
+/*! \brief Tabella di Butcher di Heun
+ */
+struct TabellaHeun{
+  static constexpr std::size_t stadi=2;
+  static constexpr double A[2][2]={
+    {0.0,0.0},
+    {1.0,0.0}
+  };
+  static constexpr double B[2]={0.5,0.5};
+};
+
+/*! \brief Tabella di Butcher del punto medio
+ */
+struct TabellaPuntoMedio{
+  static constexpr std::size_t stadi=2;
+  static constexpr double A[2][2]={
+    {0.0,0.0},
+    {0.5,0.0}
+  };
+  static constexpr double B[2]={0.0,1.0};
+};
+
+/*! \brief Tabella di Butcher di Runge Kutta classico del quarto ordine
+ */
+struct TabellaRK4{
+  static constexpr std::size_t stadi=4;
+  static constexpr double A[4][4]={
+    {0.0,0.0,0.0,0.0},
+    {0.5,0.0,0.0,0.0},
+    {0.0,0.5,0.0,0.0},
+    {0.0,0.0,1.0,0.0}
+  };
+  static constexpr double B[4]={1.0/6.0,1.0/3.0,1.0/3.0,1.0/6.0};
+};
+
+/*! \brief Tabella di Butcher della regola 3/8 del quarto ordine
+ */
+struct TabellaRK38{
+  static constexpr std::size_t stadi=4;
+  static constexpr double A[4][4]={
+    {0.0,0.0,0.0,0.0},
+    {1.0/3.0,0.0,0.0,0.0},
+    {-1.0/3.0,1.0,0.0,0.0},
+    {1.0,-1.0,1.0,0.0}
+  };
+  static constexpr double B[4]={1.0/8.0,3.0/8.0,3.0/8.0,1.0/8.0};
+};
+
+/*! \brief Tabella di Butcher di Dormand-Prince RK45 usata a passo fisso con i pesi di ordine 5
+ */
+struct TabellaRK45{
+  static constexpr std::size_t stadi=7;
+  static constexpr double A[7][7]={
+    {0.0,0.0,0.0,0.0,0.0,0.0,0.0},
+    {1.0/5.0,0.0,0.0,0.0,0.0,0.0,0.0},
+    {3.0/40.0,9.0/40.0,0.0,0.0,0.0,0.0,0.0},
+    {44.0/45.0,-56.0/15.0,32.0/9.0,0.0,0.0,0.0,0.0},
+    {19372.0/6561.0,-25360.0/2187.0,64448.0/6561.0,-212.0/729.0,0.0,0.0,0.0},
+    {9017.0/3168.0,-355.0/33.0,46732.0/5247.0,49.0/176.0,-5103.0/18656.0,0.0,0.0},
+    {35.0/384.0,0.0,500.0/1113.0,125.0/192.0,-2187.0/6784.0,11.0/84.0,0.0}
+  };
+  static constexpr double B[7]={35.0/384.0,0.0,500.0/1113.0,125.0/192.0,-2187.0/6784.0,11.0/84.0,0.0};
+};
+
+/*! \brief Metodo Runge Kutta esplicito con dimensione dello stato e tabella fissate a tempo di compilazione
+ *
+ *  Lo stato e gli stadi sono memorizzati in std::array, ogni stadio e l'aggiornamento finale sono un solo ciclo sulle componenti che somma solo i coefficienti non nulli.
+ *  Gli stadi che non contribuiscono alla soluzione non vengono calcolati. La dinamica è la stessa funzione ODE usata dagli altri metodi.
+ */
+template<std::size_t N,class Tabella>
+class Solutore{
+public:
+  using Stato=std::array<double,N>; /*!< Tipo di dato per lo stato*/
+  static constexpr std::size_t stadi=Tabella::stadi; /*!< Numero di stadi del metodo*/
+
+  /*! \brief Costruttore
+   *
+   *  \param dinamica Dinamica da integrare
+   */
+  explicit Solutore(ODE dinamica): dinamica(dinamica) {}
+
+  /*! \brief Calcola un passo del metodo sostituendo lo stato
+   *
+   *  \param t Istante dello stato
+   *  \param h Passo di integrazione
+   *  \param y Stato, alla fine contiene lo stato all'istante t+h
+   */
+  void Passo(double t,double h,Stato& y){
+    Stadi(t,h,y,std::make_index_sequence<stadi>{});
+    Aggiorna(h,y,std::make_index_sequence<stadi>{});
+  }
+
+  /*! \brief Integra come RungeKuttaEsplicito, con la stessa matrice dei risultati
+   *
+   *  \param infoSimulazione Indirizzo alla struttura dati per impostare il calcolo
+   *  \param statoIniziale Vettore per lo stato iniziale del calcolo, deve avere dimensione N
+   *  \return La funzione alloca una matrice gsl_matrix che contiene il risultato numerico, la matrice deve essere deallocata dall'utente. nullptr se la dimensione dello stato non è N
+   */
+  gsl_matrix* Integra(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+    if(statoIniziale->size != N) return nullptr;
+    const auto inizioCalcolo=std::chrono::steady_clock::now();
+    statistiche=infoSimulazione->statistiche;
+    if(statistiche) *statistiche=Statistiche{};
+    const std::size_t NumeroCampioni=(std::size_t)std::floor(infoSimulazione->T/infoSimulazione->h)+1;
+    const bool righe= infoSimulazione->disposizione == DisposizioneRighe;
+
+    //Allocazione matrice
+    gsl_matrix* O_sim= righe ? gsl_matrix_alloc(NumeroCampioni,N) : gsl_matrix_alloc(N,NumeroCampioni);
+    gsl_matrix_set_zero(O_sim);
+    Stato y;
+    for(std::size_t i=0; i<N; ++i) y[i]=gsl_vector_get(statoIniziale,i);
+    Scrivi(O_sim,righe,0,y);
+
+    double t_k_1=infoSimulazione->t0;
+    std::size_t k=1;
+    for(;k < NumeroCampioni; ++k){
+      //Se è verificata la condizione termino
+      if(infoSimulazione->condizione){
+        gsl_vector O_k_1=Vettore(y);
+        if(infoSimulazione->condizione(t_k_1,&O_k_1)) break;
+      }
+      Passo(t_k_1,infoSimulazione->h,y);
+      Scrivi(O_sim,righe,k,y);
+      t_k_1 = infoSimulazione->t0+((double)k)*infoSimulazione->h;
+    }
+
+    //Assegno gli istanti della condizione nel caso sia verificata
+    if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
+    if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
+    if(statistiche){
+      statistiche->passi=k-1;
+      statistiche->tempoTotale=Secondi(inizioCalcolo);
+      statistiche=nullptr;
+    }
+    return O_sim;
+  }
+
+private:
+  ODE dinamica;
+  Statistiche* statistiche=nullptr; //Statistiche richieste dall'integrazione in corso
+  std::array<Stato,stadi> K;
+  Stato Y;
+
+  static double Secondi(std::chrono::steady_clock::time_point inizio){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-inizio).count();
+  }
+
+  //Vettore GSL che punta ai dati di un std::array, senza allocazioni
+  static gsl_vector Vettore(Stato& x){
+    gsl_vector v={N,1,x.data(),nullptr,0};
+    return v;
+  }
+
+  static void Scrivi(gsl_matrix* O_sim,bool righe,std::size_t k,const Stato& y){
+    for(std::size_t i=0; i<N; ++i){
+      if(righe) gsl_matrix_set(O_sim,k,i,y[i]);
+      else gsl_matrix_set(O_sim,i,k,y[i]);
+    }
+  }
+
+  static constexpr double C(std::size_t j){
+    double c=0.0;
+    for(std::size_t l=0; l<stadi; ++l) c+=Tabella::A[j][l];
+    return c;
+  }
+
+  //Uno stadio serve se ha peso non nullo o se compare negli stadi successivi
+  static constexpr bool StadioUsato(std::size_t j){
+    if(Tabella::B[j] != 0.0) return true;
+    for(std::size_t l=j+1; l<stadi; ++l) if(Tabella::A[l][j] != 0.0) return true;
+    return false;
+  }
+
+  template<std::size_t J,std::size_t L>
+  void Accumula(double& somma,double h,std::size_t i) const{
+    if constexpr(Tabella::A[J][L] != 0.0) somma+=(h*Tabella::A[J][L])*K[L][i];
+  }
+
+  template<std::size_t J,std::size_t... L>
+  void Stadio(double t,double h,const Stato& y,std::index_sequence<L...>){
+    if constexpr(StadioUsato(J)){
+      for(std::size_t i=0; i<N; ++i){
+        double somma=y[i];
+        (Accumula<J,L>(somma,h,i), ...);
+        Y[i]=somma;
+      }
+      gsl_vector Y_j=Vettore(Y);
+      gsl_vector K_j=Vettore(K[J]);
+      if(statistiche){
+        const auto inizio=std::chrono::steady_clock::now();
+        dinamica(t+C(J)*h,&Y_j,&K_j);
+        statistiche->tempoDinamica+=Secondi(inizio);
+        ++(statistiche->chiamateDinamica);
+      }else{
+        dinamica(t+C(J)*h,&Y_j,&K_j);
+      }
+    }
+  }
+
+  template<std::size_t... J>
+  void Stadi(double t,double h,const Stato& y,std::index_sequence<J...>){
+    (Stadio<J>(t,h,y,std::make_index_sequence<J>{}), ...);
+  }
+
+  template<std::size_t J>
+  void AccumulaPeso(double& somma,double h,std::size_t i) const{
+    if constexpr(Tabella::B[J] != 0.0) somma+=(h*Tabella::B[J])*K[J][i];
+  }
+
+  template<std::size_t... J>
+  void Aggiorna(double h,Stato& y,std::index_sequence<J...>){
+    for(std::size_t i=0; i<N; ++i){
+      double somma=y[i];
+      (AccumulaPeso<J>(somma,h,i), ...);
+      y[i]=somma;
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,288 @@
+#include <math.h>
+#include <stdlib.h>
+#include <gsl/gsl_blas.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//Tabelle di Butcher incorporate, memorizzate in ordine prima le righe
+const double DormandPrince_A[49]={
+  0.0,0.0,0.0,0.0,0.0,0.0,0.0,
+  1.0/5.0,0.0,0.0,0.0,0.0,0.0,0.0,
+  3.0/40.0,9.0/40.0,0.0,0.0,0.0,0.0,0.0,
+  44.0/45.0,-56.0/15.0,32.0/9.0,0.0,0.0,0.0,0.0,
+  19372.0/6561.0,-25360.0/2187.0,64448.0/6561.0,-212.0/729.0,0.0,0.0,0.0,
+  9017.0/3168.0,-355.0/33.0,46732.0/5247.0,49.0/176.0,-5103.0/18656.0,0.0,0.0,
+  35.0/384.0,0.0,500.0/1113.0,125.0/192.0,-2187.0/6784.0,11.0/84.0,0.0
+};
+const double DormandPrince_B[7]={35.0/384.0,0.0,500.0/1113.0,125.0/192.0,-2187.0/6784.0,11.0/84.0,0.0};
+const double DormandPrince_Bcappello[7]={5179.0/57600.0,0.0,7571.0/16695.0,393.0/640.0,-92097.0/339200.0,187.0/2100.0,1.0/40.0};
+
+const double Fehlberg_A[36]={
+  0.0,0.0,0.0,0.0,0.0,0.0,
+  1.0/4.0,0.0,0.0,0.0,0.0,0.0,
+  3.0/32.0,9.0/32.0,0.0,0.0,0.0,0.0,
+  1932.0/2197.0,-7200.0/2197.0,7296.0/2197.0,0.0,0.0,0.0,
+  439.0/216.0,-8.0,3680.0/513.0,-845.0/4104.0,0.0,0.0,
+  -8.0/27.0,2.0,-3544.0/2565.0,1859.0/4104.0,-11.0/40.0,0.0
+};
+const double Fehlberg_B[6]={16.0/135.0,0.0,6656.0/12825.0,28561.0/56430.0,-9.0/50.0,2.0/55.0};
+const double Fehlberg_Bcappello[6]={25.0/216.0,0.0,1408.0/2565.0,2197.0/4104.0,-1.0/5.0,0.0};
+
+const double BogackiShampine_A[16]={
+  0.0,0.0,0.0,0.0,
+  1.0/2.0,0.0,0.0,0.0,
+  0.0,3.0/4.0,0.0,0.0,
+  2.0/9.0,1.0/3.0,4.0/9.0,0.0
+};
+const double BogackiShampine_B[4]={2.0/9.0,1.0/3.0,4.0/9.0,0.0};
+const double BogackiShampine_Bcappello[4]={7.0/24.0,1.0/4.0,1.0/3.0,1.0/8.0};
+
+//Coefficienti dell'interpolante naturale di Dormand-Prince (Hairer, Norsett, Wanner), correzione di quarto grado dell'interpolante di Hermite
+const double DormandPrince_D[7]={-12715105075.0/11282082432.0,0.0,87487479700.0/32700410799.0,-10690763975.0/1880347072.0,701980252875.0/199316789632.0,-1453857185.0/822651844.0,69997945.0/29380423.0};
+
+//Norma RMS dell'errore pesata con le tolleranze. Con scala nulla (tollAss=0 e componente nulla) conta solo un errore non nullo, che rende la norma infinita
+double NormaErrore(const gsl_vector* errore,const gsl_vector* y0,const gsl_vector* y1,double tollAss,double tollRel){
+  const size_t n=errore->size;
+  double somma=0.0;
+  for(size_t i=0; i<n; ++i){
+    double scala=tollAss+tollRel*GSL_MAX(fabs(gsl_vector_get(y0,i)),fabs(gsl_vector_get(y1,i)));
+    double e_i=gsl_vector_get(errore,i);
+    if(scala == 0.0){
+      if(e_i != 0.0) return GSL_POSINF;
+      continue;
+    }
+    double e=e_i/scala;
+    somma+=e*e;
+  }
+  return sqrt(somma/(double)n);
+}
+
+//Copia i primi stati calcolati in una nuova matrice dei risultati con la capacita' richiesta
+gsl_matrix* RidimensionaRisultato(gsl_matrix* O_sim,size_t usati,size_t capacita,enum Disposizione disposizione){
+  const bool righe= disposizione == DisposizioneRighe;
+  const size_t n= righe ? O_sim->size2 : O_sim->size1;
+  gsl_matrix* ridimensionata=AllocaRisultato(n,capacita,disposizione);
+  gsl_matrix_view dest= righe ? gsl_matrix_submatrix(ridimensionata,0,0,usati,n) : gsl_matrix_submatrix(ridimensionata,0,0,n,usati);
+  gsl_matrix_const_view sorg= righe ? gsl_matrix_const_submatrix(O_sim,0,0,usati,n) : gsl_matrix_const_submatrix(O_sim,0,0,n,usati);
+  gsl_matrix_memcpy(&(dest.matrix),&(sorg.matrix));
+  gsl_matrix_free(O_sim);
+  return ridimensionata;
+}
+
+gsl_vector* EspandiIstanti(gsl_vector* istanti,size_t usati){
+  gsl_vector* espanso=gsl_vector_alloc(2*istanti->size);
+  gsl_vector_view dest=gsl_vector_subvector(espanso,0,usati);
+  gsl_vector_const_view sorg=gsl_vector_const_subvector(istanti,0,usati);
+  gsl_vector_memcpy(&(dest.vector),&(sorg.vector));
+  gsl_vector_free(istanti);
+  return espanso;
+}
+
+//Passo iniziale con la procedura di Hairer-Norsett-Wanner, f0 e' la dinamica nello stato iniziale e y, f sono buffer
+double StimaPassoIniziale(struct InfoBaseSimulazione* infoSimulazione,const gsl_vector* statoIniziale,const gsl_vector* f0,unsigned ordine,double tollAss,double tollRel,double hMax,gsl_vector* y,gsl_vector* f){
+  const double esponente=1.0/((double)ordine+1.0);
+  double d0=NormaErrore(statoIniziale,statoIniziale,statoIniziale,tollAss,tollRel);
+  double d1=NormaErrore(f0,statoIniziale,statoIniziale,tollAss,tollRel);
+  double h0= (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1;
+  h0=GSL_MIN(h0,hMax);
+  gsl_vector_memcpy(y,statoIniziale);
+  gsl_blas_daxpy(h0,f0,y);
+  ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,infoSimulazione->t0+h0,y,f);
+  gsl_vector_sub(f,f0);
+  double d2=NormaErrore(f,statoIniziale,statoIniziale,tollAss,tollRel)/h0;
+  double dMax=GSL_MAX(d1,d2);
+  double h1= dMax <= 1e-15 ? GSL_MAX(1e-6,h0*1e-3) : pow(0.01/dMax,esponente);
+  return GSL_MIN(GSL_MIN(100.0*h0,h1),hMax);
+}
+
+//Se la memoria contiene tutta la traiettoria viene ampliata quando serve e gli istanti accettati vengono restituiti
+static void RungeKuttaAdattivoCalcolo(struct InfoBaseSimulazione* infoSimulazione,struct InfoAdattivo* infoAdattivo,const double* A_Butcher,const double* B_Butcher,const double* Bcappello_Butcher,const unsigned stadi,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,gsl_vector** istanti){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t n=statoIniziale->size;
+  const double tFine=infoSimulazione->t0+infoSimulazione->T;
+  const double tollAss=infoAdattivo->tolleranzaAssoluta, tollRel=infoAdattivo->tolleranzaRelativa;
+  //Con ordine 0 si usa l'ordine 1, con l'esponente piu' prudente per i metodi incorporati di uso comune
+  const unsigned ordine= infoAdattivo->ordine > 0 ? infoAdattivo->ordine : 1;
+  const double esponente=1.0/((double)ordine+1.0);
+  const double sicurezza= infoAdattivo->sicurezza > 0.0 ? infoAdattivo->sicurezza : 0.9;
+  const double beta= infoAdattivo->beta > 0.0 ? infoAdattivo->beta : 0.04;
+  const double alpha=esponente-0.75*beta;
+  const double hMax= infoAdattivo->hMax > 0.0 ? infoAdattivo->hMax : infoSimulazione->T;
+  const double facMin=0.2, facMax=5.0;
+
+  //Istanti accettati, la capacita' viene raddoppiata quando serve
+  const bool completa= memoria->finestra == 0;
+  size_t capacita=CampioniRisultato(memoria->O_sim,memoria->disposizione);
+  gsl_vector* t_sim= completa ? gsl_vector_alloc(capacita) : NULL;
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  if(completa) gsl_vector_set(t_sim,0,infoSimulazione->t0);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,statoIniziale);
+
+  //RungeKutta adattivo
+  double C_vec[stadi];
+  double* K_mat=(double*)malloc(n*stadi*sizeof(double));
+  double* y_vec=(double*)malloc(n*sizeof(double));
+  double* err_vec=(double*)malloc(n*sizeof(double));
+  double* densa_vec=(double*)malloc(n*sizeof(double));
+  gsl_matrix_view K=gsl_matrix_view_array(K_mat,n,stadi);
+  gsl_vector_view Y=gsl_vector_view_array(y_vec,n);
+  gsl_vector_view errore=gsl_vector_view_array(err_vec,n);
+  gsl_vector_view densa=gsl_vector_view_array(densa_vec,n);
+  const double* D_Butcher=infoAdattivo->densa;
+
+  //Coefficienti c_j e verifica della proprieta' FSAL (ultimo stadio uguale al passo successivo)
+  bool fsal=true;
+  for(unsigned j=0; j<stadi; ++j){
+    C_vec[j]=0.0;
+    for(unsigned l=0; l<stadi; ++l) C_vec[j]+=A_Butcher[j*stadi+l];
+    if(A_Butcher[(stadi-1)*stadi+j] != B_Butcher[j]) fsal=false;
+  }
+  if(fabs(C_vec[stadi-1]-1.0) > 1e-14) fsal=false;
+
+  gsl_vector_view K_0=gsl_matrix_column(&(K.matrix),0);
+  ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,infoSimulazione->t0,statoIniziale,&(K_0.vector));
+
+  //Passo iniziale, se non specificato si stima con la procedura di Hairer-Norsett-Wanner
+  double h=infoSimulazione->h;
+  if(h <= 0.0) h=StimaPassoIniziale(infoSimulazione,statoIniziale,&(K_0.vector),ordine,tollAss,tollRel,hMax,&(Y.vector),&(errore.vector));
+  h=GSL_MIN(h,hMax);
+
+  double t_k=infoSimulazione->t0, errPrecedente=1e-4;
+  bool rifiutato=false;
+  size_t k=0,passi=0;
+  while(t_k < tFine){
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    //Se è verificata la condizione termino
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k,&(O_k.vector));
+    if(verificaCondizione) break;
+    if(infoAdattivo->maxPassi && passi >= infoAdattivo->maxPassi) break;
+
+    //Ultimo passo allineato con la fine dell'intervallo
+    bool ultimoPasso=false;
+    if(t_k+1.01*h >= tFine){
+      h=tFine-t_k;
+      ultimoPasso=true;
+    }
+
+    //Calcolo dei K, i coefficienti nulli della tabella vengono saltati
+    for(unsigned j=1; j<stadi; ++j){
+      gsl_vector_memcpy(&(Y.vector),&(O_k.vector));
+      for(unsigned l=0; l<j; ++l){
+        double a_jl=A_Butcher[j*stadi+l];
+        if(a_jl == 0.0) continue;
+        gsl_vector_view K_l=gsl_matrix_column(&(K.matrix),l);
+        gsl_blas_daxpy(h*a_jl,&(K_l.vector),&(Y.vector));
+      }
+      gsl_vector_view K_j=gsl_matrix_column(&(K.matrix),j);
+      ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k+h*C_vec[j],&(Y.vector),&(K_j.vector));
+    }
+
+    //Soluzione di ordine superiore e stima dell'errore locale
+    gsl_vector_memcpy(&(Y.vector),&(O_k.vector));
+    gsl_vector_set_zero(&(errore.vector));
+    for(unsigned j=0; j<stadi; ++j){
+      gsl_vector_view K_j=gsl_matrix_column(&(K.matrix),j);
+      if(B_Butcher[j] != 0.0) gsl_blas_daxpy(h*B_Butcher[j],&(K_j.vector),&(Y.vector));
+      double d_j=B_Butcher[j]-Bcappello_Butcher[j];
+      if(d_j != 0.0) gsl_blas_daxpy(h*d_j,&(K_j.vector),&(errore.vector));
+    }
+    double err=NormaErrore(&(errore.vector),&(O_k.vector),&(Y.vector),tollAss,tollRel);
+    ++passi;
+
+    //Una stima non finita (dinamica NaN o tolleranza nulla) rifiuta il passo con la riduzione massima
+    double fattore;
+    if(err <= 1.0){
+      //Passo accettato
+      if(completa && k+1 == capacita){
+        memoria->O_sim=RidimensionaRisultato(memoria->O_sim,k+1,2*capacita,memoria->disposizione);
+        t_sim=EspandiIstanti(t_sim,k+1);
+        capacita*=2;
+      }
+      const double t_precedente=t_k;
+      t_k= ultimoPasso ? tFine : t_k+h;
+      ++k;
+      gsl_vector_view O_nuovo=StatoMemoria(memoria,k);
+      gsl_vector_memcpy(&(O_nuovo.vector),&(Y.vector));
+      if(completa) gsl_vector_set(t_sim,k,t_k);
+      EmettiStato(memoria,k,t_k);
+      TRACCIA_PASSO(k,t_k,h);
+
+      //Per gli eventi si conserva la dinamica all'inizio del passo, con l'uscita densa anche la correzione di quarto grado
+      if(rilevatore.info){
+        gsl_vector_memcpy(&(errore.vector),&(K_0.vector));
+        if(D_Butcher){
+          gsl_vector_set_zero(&(densa.vector));
+          for(unsigned j=0; j<stadi; ++j){
+            if(D_Butcher[j] == 0.0) continue;
+            gsl_vector_view K_j=gsl_matrix_column(&(K.matrix),j);
+            gsl_blas_daxpy(h*D_Butcher[j],&(K_j.vector),&(densa.vector));
+          }
+        }
+      }
+
+      //FSAL: l'ultimo stadio e' gia' la dinamica nel nuovo punto
+      if(fsal){
+        gsl_vector_view K_s=gsl_matrix_column(&(K.matrix),stadi-1);
+        gsl_vector_memcpy(&(K_0.vector),&(K_s.vector));
+      }else{
+        ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k,&(Y.vector),&(K_0.vector));
+      }
+      gsl_vector_view O_precedente=StatoMemoria(memoria,k-1);
+      if(RilevaEventi(&rilevatore,t_precedente,&(O_precedente.vector),t_k,&(O_nuovo.vector),&(errore.vector),&(K_0.vector),D_Butcher ? &(densa.vector) : NULL)) break;
+
+      //Controllore PI
+      fattore= err == 0.0 ? facMax : sicurezza*pow(err,-alpha)*pow(errPrecedente,beta);
+      fattore=GSL_MIN(GSL_MAX(fattore,facMin), rifiutato ? 1.0 : facMax);
+      errPrecedente=GSL_MAX(err,1e-4);
+      rifiutato=false;
+    }else{
+      //Passo rifiutato, si riduce h
+      fattore= gsl_finite(err) ? GSL_MAX(facMin,sicurezza*pow(err,-esponente)) : facMin;
+      rifiutato=true;
+      if(infoSimulazione->statistiche) ++(infoSimulazione->statistiche->passiRifiutati);
+      TRACCIA("ode: %s passo rifiutato t=%.17g h=%.17g errore=%g\n",__func__,t_k,h,err);
+    }
+    h=GSL_MIN(h*fattore,hMax);
+    //Si termina anche quando il passo non cambia piu' l'istante
+    if(h < infoAdattivo->hMin || t_k+h == t_k) break;
+  }
+
+  //Copia dei soli passi accettati
+  if(completa){
+    memoria->O_sim=RidimensionaRisultato(memoria->O_sim,k+1,k+1,memoria->disposizione);
+    if(istanti){
+      *istanti=gsl_vector_alloc(k+1);
+      gsl_vector_const_view t_usati=gsl_vector_const_subvector(t_sim,0,k+1);
+      gsl_vector_memcpy(*istanti,&(t_usati.vector));
+    }
+    gsl_vector_free(t_sim);
+  }
+
+  free(K_mat);
+  free(y_vec);
+  free(err_vec);
+  free(densa_vec);
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,k);
+}
+
+gsl_matrix* RungeKuttaAdattivo(struct InfoBaseSimulazione* infoSimulazione,struct InfoAdattivo* infoAdattivo,const double* A_Butcher,const double* B_Butcher,const double* Bcappello_Butcher,const unsigned stadi,gsl_vector* statoIniziale,gsl_vector** istanti){
+  struct MemoriaRisultato memoria;
+  MemoriaCompletaInit(&memoria,statoIniziale->size,64,infoSimulazione->disposizione);
+  RungeKuttaAdattivoCalcolo(infoSimulazione,infoAdattivo,A_Butcher,B_Butcher,Bcappello_Butcher,stadi,statoIniziale,&memoria,istanti);
+  return memoria.O_sim;
+}
+
+int RungeKuttaAdattivoFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoAdattivo* infoAdattivo,const double* A_Butcher,const double* B_Butcher,const double* Bcappello_Butcher,const unsigned stadi,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  struct MemoriaRisultato memoria;
+  MemoriaFlussoInit(&memoria,statoIniziale->size,uscita,infoSimulazione);
+  memoria.intestazione.h=0.0;
+  RungeKuttaAdattivoCalcolo(infoSimulazione,infoAdattivo,A_Butcher,B_Butcher,Bcappello_Butcher,stadi,statoIniziale,&memoria,NULL);
+  return MemoriaFlussoChiudi(&memoria);
+}
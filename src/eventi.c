@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdlib.h>
+#include <gsl/gsl_blas.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//Interpolante di Hermite cubica nel passo [t0,t0+h], con theta in [0,1]
+//y(theta) = y0 + theta*D + theta*(1-theta)*((1-theta)*(h*f0-D) + theta*(D-h*f1)) + theta^2*(1-theta)^2*correzione, con D=y1-y0
+//La correzione di quarto grado, se specificata, e' quella dell'interpolante naturale di Dormand-Prince
+void InterpolaHermite(double theta,double h,const gsl_vector* y0,const gsl_vector* y1,const gsl_vector* f0,const gsl_vector* f1,const gsl_vector* correzione,gsl_vector* y){
+  const double theta1=1.0-theta;
+  for(size_t i=0; i<y->size; ++i){
+    double y0_i=gsl_vector_get(y0,i);
+    double D=gsl_vector_get(y1,i)-y0_i;
+    double valore=y0_i+theta*D+theta*theta1*(theta1*(h*gsl_vector_get(f0,i)-D)+theta*(D-h*gsl_vector_get(f1,i)));
+    if(correzione) valore+=theta*theta*theta1*theta1*gsl_vector_get(correzione,i);
+    gsl_vector_set(y,i,valore);
+  }
+}
+
+//Valore della funzione dell'evento e, con i dati dell'utente se specificata con parametri
+static double ValoreEvento(const struct RilevatoreEventi* rilevatore,size_t e,double t,gsl_vector* y){
+  const struct Evento* evento=rilevatore->info->eventi+e;
+  return evento->funzioneParametri ? evento->funzioneParametri(t,y,rilevatore->infoSimulazione->parametri) : evento->funzione(t,y);
+}
+
+void RilevatoreEventiInit(struct RilevatoreEventi* rilevatore,struct InfoBaseSimulazione* infoSimulazione,size_t n,double t0,gsl_vector* y0){
+  rilevatore->info=infoSimulazione->eventi;
+  rilevatore->terminato=false;
+  rilevatore->tTerminale=t0;
+  if(rilevatore->info == NULL || rilevatore->info->numeroEventi == 0){
+    rilevatore->info=NULL;
+    return;
+  }
+  const size_t m=rilevatore->info->numeroEventi;
+  rilevatore->infoSimulazione=infoSimulazione;
+  rilevatore->statistiche=infoSimulazione->statistiche;
+  rilevatore->n=n;
+  rilevatore->g=(double*)malloc(m*sizeof(double));
+  rilevatore->g1=(double*)malloc(m*sizeof(double));
+  rilevatore->theta=(double*)malloc(m*sizeof(double));
+  rilevatore->trovati=(size_t*)malloc(m*sizeof(size_t));
+  rilevatore->f0=gsl_vector_alloc(n);
+  rilevatore->f1=gsl_vector_alloc(n);
+  rilevatore->y=gsl_vector_alloc(n);
+  rilevatore->info->numeroTrovati=0;
+  rilevatore->info->terminato=false;
+  for(size_t e=0; e<m; ++e) rilevatore->g[e]=ValoreEvento(rilevatore,e,t0,y0);
+}
+
+void RilevatoreEventiLibera(struct RilevatoreEventi* rilevatore){
+  if(rilevatore->info == NULL) return;
+  free(rilevatore->g);
+  free(rilevatore->g1);
+  free(rilevatore->theta);
+  free(rilevatore->trovati);
+  gsl_vector_free(rilevatore->f0);
+  gsl_vector_free(rilevatore->f1);
+  gsl_vector_free(rilevatore->y);
+}
+
+//Vero se il passaggio da g0 a g1 attraversa lo zero nel verso richiesto, uno zero all'inizio del passo non conta
+static bool Attraversamento(double g0,double g1,enum DirezioneEvento direzione){
+  bool crescente= g0 < 0.0 && g1 >= 0.0;
+  bool decrescente= g0 > 0.0 && g1 <= 0.0;
+  switch(direzione){
+    case EventoCrescente: return crescente;
+    case EventoDecrescente: return decrescente;
+    default: return crescente || decrescente;
+  }
+}
+
+struct PassoEventi{
+  struct RilevatoreEventi* rilevatore;
+  double t0,h;
+  const gsl_vector *y0,*y1,*f0,*f1,*correzione;
+};
+
+static double ValutaEvento(struct PassoEventi* passo,size_t e,double theta){
+  struct RilevatoreEventi* rilevatore=passo->rilevatore;
+  InterpolaHermite(theta,passo->h,passo->y0,passo->y1,passo->f0,passo->f1,passo->correzione,rilevatore->y);
+  return ValoreEvento(rilevatore,e,passo->t0+theta*passo->h,rilevatore->y);
+}
+
+//Metodo Illinois sull'intervallo normalizzato [0,1], restituisce l'estremo dalla parte di g1 quindi l'evento e' gia' avvenuto
+static double LocalizzaEvento(struct PassoEventi* passo,size_t e,double g0,double g1,double tolleranza){
+  double a=0.0,b=1.0,ga=g0,gb=g1;
+  int lato=0;
+  for(unsigned iterazione=0; iterazione<100 && (b-a)*fabs(passo->h) > tolleranza; ++iterazione){
+    double c=(a*gb-b*ga)/(gb-ga);
+    if(!(c > a && c < b)) c=0.5*(a+b);
+    double gc=ValutaEvento(passo,e,c);
+    if(gc == 0.0) return c;
+    if((gc > 0.0) == (gb > 0.0)){
+      b=c;
+      gb=gc;
+      if(lato == -1) ga*=0.5;
+      lato=-1;
+    }else{
+      a=c;
+      ga=gc;
+      if(lato == 1) gb*=0.5;
+      lato=1;
+    }
+  }
+  return b;
+}
+
+//I valori alla fine del passo diventano quelli all'inizio del passo successivo
+static void ScambiaValori(struct RilevatoreEventi* rilevatore){
+  double* scambio=rilevatore->g;
+  rilevatore->g=rilevatore->g1;
+  rilevatore->g1=scambio;
+}
+
+//Cerca gli eventi nel passo da (t0,y0) a (t1,y1), f0 e f1 sono la dinamica agli estremi e vengono calcolate se nullptr.
+//Gli eventi trovati vengono registrati in ordine di tempo, restituisce vero se uno di questi e' terminale
+bool RilevaEventi(struct RilevatoreEventi* rilevatore,double t0,gsl_vector* y0,double t1,gsl_vector* y1,const gsl_vector* f0,const gsl_vector* f1,const gsl_vector* correzione){
+  struct InfoEventi* info=rilevatore->info;
+  if(info == NULL) return false;
+  const size_t m=info->numeroEventi;
+  const double tolleranza= info->tolleranza > 0.0 ? info->tolleranza : 1e-12*(1.0+fabs(t1));
+
+  //Valori alla fine del passo, la dinamica serve solo se c'e' almeno un attraversamento
+  size_t numeroTrovati=0;
+  double* g1=rilevatore->g1;
+  for(size_t e=0; e<m; ++e){
+    g1[e]=ValoreEvento(rilevatore,e,t1,y1);
+    if(Attraversamento(rilevatore->g[e],g1[e],info->eventi[e].direzione)) rilevatore->trovati[numeroTrovati++]=e;
+  }
+  if(numeroTrovati == 0){
+    ScambiaValori(rilevatore);
+    return false;
+  }
+  if(f0 == NULL){
+    ChiamaDinamica(rilevatore->infoSimulazione,rilevatore->statistiche,t0,y0,rilevatore->f0);
+    f0=rilevatore->f0;
+  }
+  if(f1 == NULL){
+    ChiamaDinamica(rilevatore->infoSimulazione,rilevatore->statistiche,t1,y1,rilevatore->f1);
+    f1=rilevatore->f1;
+  }
+  struct PassoEventi passo={rilevatore,t0,t1-t0,y0,y1,f0,f1,correzione};
+
+  //Localizzazione e ordinamento per istante
+  for(size_t j=0; j<numeroTrovati; ++j){
+    size_t e=rilevatore->trovati[j];
+    rilevatore->theta[j]=LocalizzaEvento(&passo,e,rilevatore->g[e],g1[e],tolleranza);
+  }
+  for(size_t j=1; j<numeroTrovati; ++j){
+    double theta=rilevatore->theta[j];
+    size_t e=rilevatore->trovati[j], l=j;
+    for(; l>0 && rilevatore->theta[l-1] > theta; --l){
+      rilevatore->theta[l]=rilevatore->theta[l-1];
+      rilevatore->trovati[l]=rilevatore->trovati[l-1];
+    }
+    rilevatore->theta[l]=theta;
+    rilevatore->trovati[l]=e;
+  }
+
+  for(size_t j=0; j<numeroTrovati; ++j){
+    size_t e=rilevatore->trovati[j];
+    double t=t0+rilevatore->theta[j]*passo.h;
+    if(info->numeroTrovati < info->massimoRegistrati){
+      if(info->istanti) info->istanti[info->numeroTrovati]=t;
+      if(info->indici) info->indici[info->numeroTrovati]=e;
+      if(info->stati){
+        gsl_vector_view stato=gsl_matrix_column(info->stati,info->numeroTrovati);
+        InterpolaHermite(rilevatore->theta[j],passo.h,y0,y1,f0,f1,correzione,&(stato.vector));
+      }
+    }
+    ++(info->numeroTrovati);
+    if(info->eventi[e].terminale){
+      rilevatore->terminato=true;
+      rilevatore->tTerminale=t;
+      info->terminato=true;
+      return true;
+    }
+  }
+  ScambiaValori(rilevatore);
+  return false;
+}
+
+int InterpolaRisultato(struct InfoBaseSimulazione* infoSimulazione,gsl_matrix* O_sim,const gsl_vector* istanti,double t,gsl_vector* stato){
+  //Le pendenze dell'interpolante vengono ricalcolate con la dinamica, che Simplettico non richiede
+  if(infoSimulazione->dinamica == NULL && infoSimulazione->dinamicaParametri == NULL) return 2;
+  const size_t campioni=CampioniRisultato(O_sim,infoSimulazione->disposizione);
+  if(campioni < 2) return 1;
+
+  //Ricerca del passo che contiene t
+  size_t k;
+  double t_k,h;
+  if(istanti == NULL){
+    h=infoSimulazione->h;
+    double posizione=(t-infoSimulazione->t0)/h;
+    if(posizione < 0.0 || posizione > (double)(campioni-1)) return 1;
+    k=GSL_MIN((size_t)posizione,campioni-2);
+    t_k=infoSimulazione->t0+((double)k)*h;
+  }else{
+    const size_t ultimo=GSL_MIN(istanti->size,campioni)-1;
+    if(ultimo == 0 || t < gsl_vector_get(istanti,0) || t > gsl_vector_get(istanti,ultimo)) return 1;
+    size_t basso=0,alto=ultimo;
+    while(alto-basso > 1){
+      size_t medio=(basso+alto)/2;
+      if(gsl_vector_get(istanti,medio) <= t) basso=medio;
+      else alto=medio;
+    }
+    k=basso;
+    t_k=gsl_vector_get(istanti,k);
+    h=gsl_vector_get(istanti,k+1)-t_k;
+  }
+
+  gsl_vector_view y0=StatoRisultato(O_sim,k,infoSimulazione->disposizione);
+  gsl_vector_view y1=StatoRisultato(O_sim,k+1,infoSimulazione->disposizione);
+  gsl_vector* f0=gsl_vector_alloc(stato->size);
+  gsl_vector* f1=gsl_vector_alloc(stato->size);
+  ChiamaDinamica(infoSimulazione,NULL,t_k,&(y0.vector),f0);
+  ChiamaDinamica(infoSimulazione,NULL,t_k+h,&(y1.vector),f1);
+  InterpolaHermite((t-t_k)/h,h,&(y0.vector),&(y1.vector),f0,f1,NULL,stato);
+  gsl_vector_free(f0);
+  gsl_vector_free(f1);
+  return 0;
+}
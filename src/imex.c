@@ -0,0 +1,240 @@
+#include <math.h>
+#include <stdlib.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//ARS(2,2,2) con gamma=1-1/sqrt(2) e delta=1-1/(2*gamma)=-1/sqrt(2)
+static const double ARS222_AE[9]={
+  0.0,0.0,0.0,
+  0.29289321881345247560,0.0,0.0,
+  -0.70710678118654752440,1.70710678118654752440,0.0
+};
+static const double ARS222_BE[3]={-0.70710678118654752440,1.70710678118654752440,0.0};
+static const double ARS222_AI[9]={
+  0.0,0.0,0.0,
+  0.0,0.29289321881345247560,0.0,
+  0.0,0.70710678118654752440,0.29289321881345247560
+};
+static const double ARS222_BI[3]={0.0,0.70710678118654752440,0.29289321881345247560};
+static const double ARS222_C[3]={0.0,0.29289321881345247560,1.0};
+
+//ARS(4,4,3)
+static const double ARS443_AE[25]={
+  0.0,0.0,0.0,0.0,0.0,
+  1.0/2.0,0.0,0.0,0.0,0.0,
+  11.0/18.0,1.0/18.0,0.0,0.0,0.0,
+  5.0/6.0,-5.0/6.0,1.0/2.0,0.0,0.0,
+  1.0/4.0,7.0/4.0,3.0/4.0,-7.0/4.0,0.0
+};
+static const double ARS443_BE[5]={1.0/4.0,7.0/4.0,3.0/4.0,-7.0/4.0,0.0};
+static const double ARS443_AI[25]={
+  0.0,0.0,0.0,0.0,0.0,
+  0.0,1.0/2.0,0.0,0.0,0.0,
+  0.0,1.0/6.0,1.0/2.0,0.0,0.0,
+  0.0,-1.0/2.0,1.0/2.0,1.0/2.0,0.0,
+  0.0,3.0/2.0,-3.0/2.0,1.0/2.0,1.0/2.0
+};
+static const double ARS443_BI[5]={0.0,3.0/2.0,-3.0/2.0,1.0/2.0,1.0/2.0};
+static const double ARS443_C[5]={0.0,1.0/2.0,2.0/3.0,1.0/2.0,1.0};
+
+/*! \brief Coppia di tabelle di Butcher di un metodo IMEX, memorizzate in ordine prima le righe
+ */
+struct TabellaIMEX{
+  unsigned stadi; /*!< Numero di stadi, il primo esplicito*/
+  const double* AE; /*!< Coefficienti della parte esplicita*/
+  const double* BE; /*!< Pesi della parte esplicita*/
+  const double* AI; /*!< Coefficienti della parte implicita*/
+  const double* BI; /*!< Pesi della parte implicita*/
+  const double* C; /*!< Istanti degli stadi, comuni alle due tabelle*/
+};
+
+static const struct TabellaIMEX TabelleIMEX[]={
+  {3,ARS222_AE,ARS222_BE,ARS222_AI,ARS222_BI,ARS222_C},
+  {5,ARS443_AE,ARS443_BE,ARS443_AI,ARS443_BI,ARS443_C}
+};
+
+/*! \brief Buffer di un calcolo IMEX
+ */
+struct CalcoloIMEX{
+  const struct InfoIMEX* infoIMEX; /*!< Parte rigida*/
+  struct InfoBaseSimulazione infoRigida; /*!< Impostazioni del calcolo con la parte rigida come dinamica, per il risolutore implicito*/
+  gsl_matrix* LU; /*!< Con la parte rigida lineare, fattorizzazione di I-gamma*L*/
+  gsl_permutation* permutazione; /*!< Permutazione della fattorizzazione*/
+  double gammaFattorizzato; /*!< Valore di gamma della fattorizzazione, NaN se non disponibile*/
+  struct SolutoreImplicito solutore; /*!< Con la parte rigida non lineare, risolutore delle equazioni degli stadi*/
+};
+
+//f_I(t,y), come prodotto con la matrice se la parte rigida e' lineare
+static void ChiamaRigida(struct CalcoloIMEX* calcolo,double t,gsl_vector* y,gsl_vector* f){
+  if(calcolo->infoIMEX->L) gsl_blas_dgemv(CblasNoTrans,1.0,calcolo->infoIMEX->L,y,0.0,f);
+  else ChiamaDinamica(&(calcolo->infoRigida),calcolo->infoRigida.statistiche,t,y,f);
+}
+
+//Soluzione di y = r + gamma*f_I(t,y), y contiene la stima iniziale
+static void RisolviStadio(struct CalcoloIMEX* calcolo,double t,double gamma,const gsl_vector* r,gsl_vector* y){
+  if(calcolo->infoIMEX->L == NULL){
+    RisolviImplicito(&(calcolo->solutore),t,gamma,r,y);
+    return;
+  }
+  //Con la diagonale costante delle tabelle ARS la matrice viene fattorizzata una volta per calcolo
+  if(!(gamma == calcolo->gammaFattorizzato)){
+    int segno;
+    gsl_matrix_memcpy(calcolo->LU,calcolo->infoIMEX->L);
+    gsl_matrix_scale(calcolo->LU,-gamma);
+    gsl_matrix_add_diagonal(calcolo->LU,1.0);
+    gsl_linalg_LU_decomp(calcolo->LU,calcolo->permutazione,&segno);
+    calcolo->gammaFattorizzato=gamma;
+    if(calcolo->infoRigida.statistiche) ++(calcolo->infoRigida.statistiche->fattorizzazioni);
+  }
+  gsl_vector_memcpy(y,r);
+  gsl_linalg_LU_svx(calcolo->LU,calcolo->permutazione,y);
+}
+
+//Dinamica completa f_E+f_I per l'interpolante degli eventi, f_I in buffer
+static void DinamicaCompleta(struct CalcoloIMEX* calcolo,struct InfoBaseSimulazione* infoSimulazione,double t,gsl_vector* y,gsl_vector* f,gsl_vector* buffer){
+  ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t,y,f);
+  ChiamaRigida(calcolo,t,y,buffer);
+  gsl_vector_add(f,buffer);
+}
+
+static void RungeKuttaIMEXCalcolo(struct InfoBaseSimulazione* infoSimulazione,struct InfoIMEX* infoIMEX,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
+  const size_t n=statoIniziale->size;
+  const double h=infoSimulazione->h;
+  const struct TabellaIMEX* tabella=TabelleIMEX+infoIMEX->metodo;
+  const unsigned stadi=tabella->stadi;
+
+  struct CalcoloIMEX calcolo;
+  calcolo.infoIMEX=infoIMEX;
+  calcolo.infoRigida=*infoSimulazione;
+  calcolo.infoRigida.dinamica=NULL;
+  calcolo.infoRigida.dinamicaParametri=infoIMEX->rigida;
+  calcolo.infoRigida.dinamicaBlocco=NULL;
+  calcolo.LU=NULL;
+  calcolo.permutazione=NULL;
+  calcolo.gammaFattorizzato=GSL_NAN;
+  if(infoIMEX->L){
+    calcolo.LU=gsl_matrix_alloc(n,n);
+    calcolo.permutazione=gsl_permutation_alloc(n);
+  }else{
+    SolutoreImplicitoInit(&(calcolo.solutore),&(calcolo.infoRigida),n);
+  }
+  //Stadi per colonne, uno stadio serve se il suo peso o un coefficiente degli stadi successivi non e' nullo
+  gsl_matrix* KE=gsl_matrix_alloc(n,stadi);
+  gsl_matrix* KI=gsl_matrix_alloc(n,stadi);
+  gsl_vector* r=gsl_vector_alloc(n);
+  bool serveE[stadi],serveI[stadi];
+  for(unsigned j=0; j<stadi; ++j){
+    serveE[j]= tabella->BE[j] != 0.0;
+    serveI[j]= tabella->BI[j] != 0.0;
+    for(unsigned i=j+1; i<stadi; ++i){
+      serveE[j]= serveE[j] || tabella->AE[i*stadi+j] != 0.0;
+      serveI[j]= serveI[j] || tabella->AI[i*stadi+j] != 0.0;
+    }
+  }
+
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
+  //La dinamica completa agli estremi del passo serve solo agli eventi, quella finale diventa l'iniziale del passo successivo
+  gsl_vector* f_k_1=NULL,*f_k=NULL;
+  if(rilevatore.info){
+    f_k_1=gsl_vector_alloc(n);
+    f_k=gsl_vector_alloc(n);
+    DinamicaCompleta(&calcolo,infoSimulazione,infoSimulazione->t0,&(O_0.vector),f_k_1,r);
+  }
+
+  double t_k=infoSimulazione->t0+h,t_k_1=infoSimulazione->t0;
+  size_t k=1;
+  for(;k < NumeroCampioni; ++k){
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
+    //Se è verificata la condizione termino
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
+    if(verificaCondizione) break;
+
+    //O_k contiene lo stadio corrente, che e' la stima iniziale dello stadio successivo
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
+    for(unsigned i=0; i<stadi; ++i){
+      const double t_i=t_k_1+h*tabella->C[i];
+      const double gamma=h*tabella->AI[i*stadi+i];
+      gsl_vector_memcpy(r,&(O_k_1.vector));
+      for(unsigned j=0; j<i; ++j){
+        const double aE=tabella->AE[i*stadi+j], aI=tabella->AI[i*stadi+j];
+        gsl_vector_view KE_j=gsl_matrix_column(KE,j);
+        gsl_vector_view KI_j=gsl_matrix_column(KI,j);
+        if(aE != 0.0) gsl_blas_daxpy(h*aE,&(KE_j.vector),r);
+        if(aI != 0.0) gsl_blas_daxpy(h*aI,&(KI_j.vector),r);
+      }
+      gsl_vector_view KE_i=gsl_matrix_column(KE,i);
+      gsl_vector_view KI_i=gsl_matrix_column(KI,i);
+      if(gamma == 0.0){
+        gsl_vector_memcpy(&(O_k.vector),r);
+        if(serveI[i]) ChiamaRigida(&calcolo,t_i,&(O_k.vector),&(KI_i.vector));
+      }else{
+        //f_I dello stadio ricavata dalla soluzione, senza valutarla di nuovo
+        RisolviStadio(&calcolo,t_i,gamma,r,&(O_k.vector));
+        gsl_vector_memcpy(&(KI_i.vector),&(O_k.vector));
+        gsl_vector_sub(&(KI_i.vector),r);
+        gsl_vector_scale(&(KI_i.vector),1.0/gamma);
+      }
+      if(serveE[i]) ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_i,&(O_k.vector),&(KE_i.vector));
+    }
+
+    //Calcolo passo successivo
+    gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
+    for(unsigned j=0; j<stadi; ++j){
+      gsl_vector_view KE_j=gsl_matrix_column(KE,j);
+      gsl_vector_view KI_j=gsl_matrix_column(KI,j);
+      if(tabella->BE[j] != 0.0) gsl_blas_daxpy(h*tabella->BE[j],&(KE_j.vector),&(O_k.vector));
+      if(tabella->BI[j] != 0.0) gsl_blas_daxpy(h*tabella->BI[j],&(KI_j.vector),&(O_k.vector));
+    }
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,h);
+    if(rilevatore.info){
+      DinamicaCompleta(&calcolo,infoSimulazione,t_k,&(O_k.vector),f_k,r);
+      if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),f_k_1,f_k,NULL)) break;
+      gsl_vector* scambio=f_k_1;
+      f_k_1=f_k;
+      f_k=scambio;
+    }
+    t_k_1=t_k;
+    t_k = infoSimulazione->t0+((double)(k+1))*h;
+  }
+  RilevatoreEventiLibera(&rilevatore);
+  gsl_matrix_free(KE);
+  gsl_matrix_free(KI);
+  gsl_vector_free(r);
+  if(f_k_1) gsl_vector_free(f_k_1);
+  if(f_k) gsl_vector_free(f_k);
+  if(infoIMEX->L){
+    gsl_matrix_free(calcolo.LU);
+    gsl_permutation_free(calcolo.permutazione);
+  }else{
+    SolutoreImplicitoLibera(&(calcolo.solutore));
+  }
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
+}
+
+gsl_matrix* RungeKuttaIMEX(struct InfoBaseSimulazione* infoSimulazione,struct InfoIMEX* infoIMEX,gsl_vector* statoIniziale){
+  struct MemoriaRisultato memoria;
+  MemoriaCompletaInit(&memoria,statoIniziale->size,CampioniSimulazione(infoSimulazione),infoSimulazione->disposizione);
+  RungeKuttaIMEXCalcolo(infoSimulazione,infoIMEX,statoIniziale,&memoria);
+  return memoria.O_sim;
+}
+
+int RungeKuttaIMEXFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoIMEX* infoIMEX,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  struct MemoriaRisultato memoria;
+  MemoriaFlussoInit(&memoria,statoIniziale->size,uscita,infoSimulazione);
+  RungeKuttaIMEXCalcolo(infoSimulazione,infoIMEX,statoIniziale,&memoria);
+  return MemoriaFlussoChiudi(&memoria);
+}
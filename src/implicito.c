@@ -0,0 +1,711 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//Colorazione delle colonne di una matrice a banda: colonne distanti almeno bandaInferiore+bandaSuperiore+1 non hanno righe in comune
+static void ColoraBanda(struct SolutoreImplicito* solutore){
+  const size_t n=solutore->n;
+  const size_t larghezza=GSL_MIN(solutore->info.bandaInferiore+solutore->info.bandaSuperiore+1,n);
+  solutore->numeroColori=larghezza;
+  solutore->colonneColore=(size_t*)malloc(n*sizeof(size_t));
+  solutore->inizioColori=(size_t*)malloc((larghezza+1)*sizeof(size_t));
+  size_t k=0;
+  for(size_t c=0; c<larghezza; ++c){
+    solutore->inizioColori[c]=k;
+    for(size_t j=c; j<n; j+=larghezza) solutore->colonneColore[k++]=j;
+  }
+  solutore->inizioColori[larghezza]=n;
+}
+
+//Trasposta della struttura CSR e colorazione greedy delle colonne: due colonne con una riga in comune hanno colori diversi
+static void ColoraSparso(struct SolutoreImplicito* solutore){
+  const size_t n=solutore->n;
+  const size_t* inizioRighe=solutore->info.inizioRighe;
+  const size_t* colonne=solutore->info.colonne;
+  const size_t nonNulli=inizioRighe[n];
+
+  solutore->inizioColonne=(size_t*)calloc(n+1,sizeof(size_t));
+  solutore->posizioniColonne=(size_t*)malloc(nonNulli*sizeof(size_t));
+  solutore->righeColonne=(size_t*)malloc(nonNulli*sizeof(size_t));
+  for(size_t p=0; p<nonNulli; ++p) ++(solutore->inizioColonne[colonne[p]+1]);
+  for(size_t j=0; j<n; ++j) solutore->inizioColonne[j+1]+=solutore->inizioColonne[j];
+  size_t* riempite=(size_t*)malloc(n*sizeof(size_t));
+  memcpy(riempite,solutore->inizioColonne,n*sizeof(size_t));
+  for(size_t i=0; i<n; ++i){
+    for(size_t p=inizioRighe[i]; p<inizioRighe[i+1]; ++p){
+      size_t q=riempite[colonne[p]]++;
+      solutore->posizioniColonne[q]=p;
+      solutore->righeColonne[q]=i;
+    }
+  }
+
+  //vietato[c] == j se il colore c e' gia' usato da una colonna adiacente a j
+  size_t* colore=riempite;
+  size_t* vietato=(size_t*)malloc(n*sizeof(size_t));
+  size_t numeroColori=0;
+  for(size_t j=0; j<n; ++j){
+    for(size_t q=solutore->inizioColonne[j]; q<solutore->inizioColonne[j+1]; ++q){
+      size_t i=solutore->righeColonne[q];
+      for(size_t p=inizioRighe[i]; p<inizioRighe[i+1]; ++p){
+        if(colonne[p] < j) vietato[colore[colonne[p]]]=j;
+      }
+    }
+    size_t c=0;
+    while(c < numeroColori && vietato[c] == j) ++c;
+    if(c == numeroColori) vietato[numeroColori++]=SIZE_MAX;
+    colore[j]=c;
+  }
+
+  //Ordinamento delle colonne per colore
+  solutore->numeroColori=numeroColori;
+  solutore->colonneColore=(size_t*)malloc(n*sizeof(size_t));
+  solutore->inizioColori=(size_t*)calloc(numeroColori+1,sizeof(size_t));
+  for(size_t j=0; j<n; ++j) ++(solutore->inizioColori[colore[j]+1]);
+  for(size_t c=0; c<numeroColori; ++c) solutore->inizioColori[c+1]+=solutore->inizioColori[c];
+  memcpy(vietato,solutore->inizioColori,numeroColori*sizeof(size_t));
+  for(size_t j=0; j<n; ++j) solutore->colonneColore[vietato[colore[j]]++]=j;
+  free(colore);
+  free(vietato);
+}
+
+void SolutoreImplicitoInit(struct SolutoreImplicito* solutore,struct InfoBaseSimulazione* infoSimulazione,size_t n){
+  //Impostazioni predefinite, equivalenti alle iterazioni di punto fisso originali
+  struct InfoImplicito predefinito={PuntoFisso,NULL,0.0,0,0.0,JacobianoDenso,0,0,NULL,NULL,0.0,0,NULL};
+  solutore->info= infoSimulazione->implicito == NULL ? predefinito : *(infoSimulazione->implicito);
+  if(solutore->info.tolleranza <= 0.0) solutore->info.tolleranza= solutore->info.metodo == Newton ? 1e-10 : 1e-15;
+  if(solutore->info.maxIterazioni == 0) solutore->info.maxIterazioni=50;
+  if(solutore->info.contrazioneMax <= 0.0) solutore->info.contrazioneMax=0.5;
+  if(solutore->info.tolleranzaKrylov <= 0.0) solutore->info.tolleranzaKrylov=1e-6;
+  if(solutore->info.dimensioneKrylov == 0) solutore->info.dimensioneKrylov=30;
+  if(solutore->info.struttura != JacobianoDenso){
+    solutore->info.jacobiano=NULL;
+    solutore->info.jacobianoParametri=NULL;
+  }
+  
+  solutore->infoSimulazione=infoSimulazione;
+  solutore->statistiche=infoSimulazione->statistiche;
+  solutore->n=n;
+  solutore->f=gsl_vector_alloc(n);
+  solutore->delta=gsl_vector_alloc(n);
+  solutore->iniziale=gsl_vector_alloc(n);
+  solutore->J=NULL;
+  solutore->LU=NULL;
+  solutore->permutazione=NULL;
+  solutore->pivot=NULL;
+  solutore->valori=NULL;
+  solutore->fattori=NULL;
+  solutore->diagonale=NULL;
+  solutore->posizioniRiga=NULL;
+  solutore->inizioColonne=NULL;
+  solutore->posizioniColonne=NULL;
+  solutore->righeColonne=NULL;
+  solutore->colonneColore=NULL;
+  solutore->inizioColori=NULL;
+  solutore->numeroColori=n;
+  solutore->perturbato=NULL;
+  solutore->statiColori=NULL;
+  solutore->derivateColori=NULL;
+  solutore->V=NULL;
+  solutore->H=NULL;
+  solutore->rotazioni=NULL;
+  solutore->g=NULL;
+  solutore->w=NULL;
+  solutore->b=NULL;
+  solutore->fPerturbato=NULL;
+  solutore->y=NULL;
+  solutore->t=GSL_NAN;
+  if(solutore->info.metodo == Newton){
+    const size_t kl=solutore->info.bandaInferiore, ku=solutore->info.bandaSuperiore;
+    const size_t m=solutore->info.dimensioneKrylov;
+    switch(solutore->info.struttura){
+      case JacobianoDenso:
+        solutore->J=gsl_matrix_alloc(n,n);
+        solutore->LU=gsl_matrix_alloc(n,n);
+        solutore->permutazione=gsl_permutation_alloc(n);
+        break;
+      case JacobianoBanda:
+        solutore->J=gsl_matrix_alloc(n,kl+ku+1);
+        solutore->LU=gsl_matrix_alloc(n,2*kl+ku+1);
+        solutore->pivot=(size_t*)malloc(n*sizeof(size_t));
+        solutore->perturbato=gsl_vector_alloc(n);
+        ColoraBanda(solutore);
+        break;
+      case JacobianoSparso:
+        solutore->valori=(double*)malloc(solutore->info.inizioRighe[n]*sizeof(double));
+        solutore->fattori=(double*)malloc(solutore->info.inizioRighe[n]*sizeof(double));
+        solutore->diagonale=(double*)malloc(n*sizeof(double));
+        solutore->posizioniRiga=(size_t*)malloc(n*sizeof(size_t));
+        for(size_t j=0; j<n; ++j) solutore->posizioniRiga[j]=SIZE_MAX;
+        solutore->perturbato=gsl_vector_alloc(n);
+        ColoraSparso(solutore);
+        break;
+      case JacobianoLibero:
+        solutore->perturbato=gsl_vector_alloc(n);
+        solutore->fPerturbato=gsl_vector_alloc(n);
+        break;
+    }
+    //Con la dinamica a blocchi tutti gli stati perturbati vengono valutati in una chiamata
+    if(infoSimulazione->dinamicaBlocco && (solutore->info.struttura == JacobianoBanda || solutore->info.struttura == JacobianoSparso)){
+      solutore->statiColori=gsl_matrix_alloc(n,solutore->numeroColori);
+      solutore->derivateColori=gsl_matrix_alloc(n,solutore->numeroColori);
+    }
+    if(solutore->info.struttura == JacobianoSparso || solutore->info.struttura == JacobianoLibero){
+      solutore->V=gsl_matrix_alloc(m+1,n);
+      solutore->H=gsl_matrix_alloc(m+1,m);
+      solutore->rotazioni=gsl_vector_alloc(2*m);
+      solutore->g=gsl_vector_alloc(m+1);
+      solutore->w=gsl_vector_alloc(n);
+      solutore->b=gsl_vector_alloc(n);
+    }
+  }
+  solutore->jacobianoValido=false;
+  solutore->gammaFattorizzato=GSL_NAN;
+  solutore->variazioneGamma=0.0;
+  solutore->contrazione=0.0;
+  solutore->tolleranzaAssoluta=0.0;
+  solutore->tolleranzaRelativa=0.0;
+}
+
+void SolutoreImplicitoLibera(struct SolutoreImplicito* solutore){
+  gsl_vector_free(solutore->f);
+  gsl_vector_free(solutore->delta);
+  gsl_vector_free(solutore->iniziale);
+  if(solutore->J) gsl_matrix_free(solutore->J);
+  if(solutore->LU) gsl_matrix_free(solutore->LU);
+  if(solutore->permutazione) gsl_permutation_free(solutore->permutazione);
+  free(solutore->pivot);
+  free(solutore->valori);
+  free(solutore->fattori);
+  free(solutore->diagonale);
+  free(solutore->posizioniRiga);
+  free(solutore->inizioColonne);
+  free(solutore->posizioniColonne);
+  free(solutore->righeColonne);
+  free(solutore->colonneColore);
+  free(solutore->inizioColori);
+  if(solutore->perturbato) gsl_vector_free(solutore->perturbato);
+  if(solutore->statiColori) gsl_matrix_free(solutore->statiColori);
+  if(solutore->derivateColori) gsl_matrix_free(solutore->derivateColori);
+  if(solutore->V) gsl_matrix_free(solutore->V);
+  if(solutore->H) gsl_matrix_free(solutore->H);
+  if(solutore->rotazioni) gsl_vector_free(solutore->rotazioni);
+  if(solutore->g) gsl_vector_free(solutore->g);
+  if(solutore->w) gsl_vector_free(solutore->w);
+  if(solutore->b) gsl_vector_free(solutore->b);
+  if(solutore->fPerturbato) gsl_vector_free(solutore->fPerturbato);
+}
+
+//Prepara il risolutore, gia' allocato, per un nuovo calcolo: lo jacobiano del calcolo precedente non viene riusato
+void SolutoreImplicitoRiavvia(struct SolutoreImplicito* solutore,struct InfoBaseSimulazione* infoSimulazione){
+  solutore->infoSimulazione=infoSimulazione;
+  solutore->statistiche=infoSimulazione->statistiche;
+  solutore->jacobianoValido=false;
+  solutore->gammaFattorizzato=GSL_NAN;
+}
+
+//Jacobiano alle differenze finite in avanti, f_y deve contenere f(t,y)
+static void JacobianoDifferenzeFinite(struct SolutoreImplicito* solutore,double t,gsl_vector* y,const gsl_vector* f_y){
+  const double radiceEps=sqrt(GSL_DBL_EPSILON);
+  if(solutore->infoSimulazione->dinamicaBlocco){
+    //Stati perturbati per colonne in LU, che viene comunque sovrascritta dalla fattorizzazione
+    for(size_t j=0; j<solutore->n; ++j){
+      gsl_vector_view S_j=gsl_matrix_column(solutore->LU,j);
+      gsl_vector_memcpy(&(S_j.vector),y);
+      double y_j=gsl_vector_get(y,j);
+      gsl_vector_set(&(S_j.vector),j,y_j+radiceEps*GSL_MAX(fabs(y_j),1.0));
+    }
+    ChiamaDinamicaBlocco(solutore->infoSimulazione,solutore->statistiche,t,solutore->LU,solutore->J);
+    for(size_t j=0; j<solutore->n; ++j){
+      double y_j=gsl_vector_get(y,j);
+      gsl_vector_view J_j=gsl_matrix_column(solutore->J,j);
+      gsl_vector_sub(&(J_j.vector),f_y);
+      gsl_vector_scale(&(J_j.vector),1.0/(radiceEps*GSL_MAX(fabs(y_j),1.0)));
+    }
+    return;
+  }
+  for(size_t j=0; j<solutore->n; ++j){
+    double y_j=gsl_vector_get(y,j);
+    double incremento=radiceEps*GSL_MAX(fabs(y_j),1.0);
+    gsl_vector_set(y,j,y_j+incremento);
+    gsl_vector_view J_j=gsl_matrix_column(solutore->J,j);
+    ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,t,y,&(J_j.vector));
+    gsl_vector_sub(&(J_j.vector),f_y);
+    gsl_vector_scale(&(J_j.vector),1.0/incremento);
+    gsl_vector_set(y,j,y_j);
+  }
+}
+
+//Incremento delle differenze finite, rappresentato esattamente nella somma con y_j
+static double IncrementoColonna(double y_j){
+  double incremento=sqrt(GSL_DBL_EPSILON)*GSL_MAX(fabs(y_j),1.0);
+  return (y_j+incremento)-y_j;
+}
+
+//Jacobiano a banda o sparso alle differenze finite in avanti, con una valutazione della dinamica per ogni colore
+static void JacobianoColorato(struct SolutoreImplicito* solutore,double t,const gsl_vector* y,const gsl_vector* f_y){
+  const size_t n=solutore->n;
+  const size_t kl=solutore->info.bandaInferiore, ku=solutore->info.bandaSuperiore;
+  const bool blocco= solutore->statiColori != NULL;
+  gsl_vector_memcpy(solutore->perturbato,y);
+  if(blocco){
+    for(size_t c=0; c<solutore->numeroColori; ++c){
+      gsl_vector_view S_c=gsl_matrix_column(solutore->statiColori,c);
+      gsl_vector_memcpy(&(S_c.vector),y);
+      for(size_t k=solutore->inizioColori[c]; k<solutore->inizioColori[c+1]; ++k){
+        size_t j=solutore->colonneColore[k];
+        double y_j=gsl_vector_get(y,j);
+        gsl_vector_set(&(S_c.vector),j,y_j+IncrementoColonna(y_j));
+      }
+    }
+    ChiamaDinamicaBlocco(solutore->infoSimulazione,solutore->statistiche,t,solutore->statiColori,solutore->derivateColori);
+  }
+  for(size_t c=0; c<solutore->numeroColori; ++c){
+    const gsl_vector* f_c=solutore->delta;
+    gsl_vector_view D_c;
+    if(blocco){
+      D_c=gsl_matrix_column(solutore->derivateColori,c);
+      f_c=&(D_c.vector);
+    }else{
+      for(size_t k=solutore->inizioColori[c]; k<solutore->inizioColori[c+1]; ++k){
+        size_t j=solutore->colonneColore[k];
+        double y_j=gsl_vector_get(y,j);
+        gsl_vector_set(solutore->perturbato,j,y_j+IncrementoColonna(y_j));
+      }
+      ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,t,solutore->perturbato,solutore->delta);
+    }
+    for(size_t k=solutore->inizioColori[c]; k<solutore->inizioColori[c+1]; ++k){
+      size_t j=solutore->colonneColore[k];
+      double y_j=gsl_vector_get(y,j);
+      double inverso=1.0/IncrementoColonna(y_j);
+      gsl_vector_set(solutore->perturbato,j,y_j);
+      if(solutore->info.struttura == JacobianoBanda){
+        const size_t ultima=GSL_MIN(n-1,j+kl);
+        for(size_t i= j > ku ? j-ku : 0; i<=ultima; ++i) gsl_matrix_set(solutore->J,i,j+kl-i,(gsl_vector_get(f_c,i)-gsl_vector_get(f_y,i))*inverso);
+      }else{
+        for(size_t q=solutore->inizioColonne[j]; q<solutore->inizioColonne[j+1]; ++q){
+          size_t i=solutore->righeColonne[q];
+          solutore->valori[solutore->posizioniColonne[q]]=(gsl_vector_get(f_c,i)-gsl_vector_get(f_y,i))*inverso;
+        }
+      }
+    }
+  }
+}
+
+//Jacobiano in (t,y), f_y e' f(t,y) se gia' calcolata oppure nullptr
+static void AggiornaJacobiano(struct SolutoreImplicito* solutore,double t,gsl_vector* y,const gsl_vector* f_y){
+  //Senza jacobiano il prodotto alle differenze finite usa sempre lo stato corrente
+  if(solutore->info.struttura == JacobianoLibero){
+    solutore->jacobianoValido=true;
+    return;
+  }
+  if(solutore->info.jacobianoParametri){
+    solutore->info.jacobianoParametri(t,y,solutore->J,solutore->infoSimulazione->parametri);
+  }else if(solutore->info.jacobiano){
+    solutore->info.jacobiano(t,y,solutore->J);
+  }else{
+    if(f_y == NULL){
+      ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,t,y,solutore->f);
+      f_y=solutore->f;
+    }
+    if(solutore->info.struttura == JacobianoDenso) JacobianoDifferenzeFinite(solutore,t,y,f_y);
+    else JacobianoColorato(solutore,t,y,f_y);
+  }
+  solutore->jacobianoValido=true;
+  solutore->gammaFattorizzato=GSL_NAN;
+  if(solutore->statistiche) ++(solutore->statistiche->jacobiani);
+}
+
+//Fattorizzazione LU a banda con pivoting parziale. L'elemento (i,j) e' nella colonna j-i+bandaInferiore di LU, quindi dopo gli scambi
+//la riga i arriva fino alla colonna i+bandaInferiore+bandaSuperiore cioe' all'ultima di LU. I moltiplicatori di L restano nella riga in cui sono stati calcolati come in dgbtrf di LAPACK
+static void FattorizzaBanda(struct SolutoreImplicito* solutore,double gamma){
+  const size_t n=solutore->n;
+  const size_t kl=solutore->info.bandaInferiore, ku=solutore->info.bandaSuperiore;
+  gsl_matrix* LU=solutore->LU;
+  gsl_matrix_set_zero(LU);
+  for(size_t i=0; i<n; ++i){
+    const size_t ultima=GSL_MIN(n-1,i+ku);
+    for(size_t j= i > kl ? i-kl : 0; j<=ultima; ++j){
+      double valore=-gamma*gsl_matrix_get(solutore->J,i,j+kl-i);
+      if(i == j) valore+=1.0;
+      gsl_matrix_set(LU,i,j+kl-i,valore);
+    }
+  }
+#define LU_BANDA(i,j) (LU->data[(i)*LU->tda+(j)+kl-(i)])
+  for(size_t k=0; k<n; ++k){
+    const size_t ultimaRiga=GSL_MIN(n-1,k+kl), ultimaColonna=GSL_MIN(n-1,k+kl+ku);
+    size_t p=k;
+    for(size_t i=k+1; i<=ultimaRiga; ++i){
+      if(fabs(LU_BANDA(i,k)) > fabs(LU_BANDA(p,k))) p=i;
+    }
+    solutore->pivot[k]=p;
+    if(p != k){
+      for(size_t j=k; j<=ultimaColonna; ++j){
+        double scambio=LU_BANDA(k,j);
+        LU_BANDA(k,j)=LU_BANDA(p,j);
+        LU_BANDA(p,j)=scambio;
+      }
+    }
+    const double pivot=LU_BANDA(k,k);
+    if(pivot == 0.0) continue;
+    for(size_t i=k+1; i<=ultimaRiga; ++i){
+      double l=LU_BANDA(i,k)/pivot;
+      LU_BANDA(i,k)=l;
+      for(size_t j=k+1; j<=ultimaColonna; ++j) LU_BANDA(i,j)-=l*LU_BANDA(k,j);
+    }
+  }
+}
+
+//Soluzione in place con la fattorizzazione di FattorizzaBanda
+static void RisolviBanda(struct SolutoreImplicito* solutore,gsl_vector* x){
+  const size_t n=solutore->n;
+  const size_t kl=solutore->info.bandaInferiore, ku=solutore->info.bandaSuperiore;
+  const gsl_matrix* LU=solutore->LU;
+  for(size_t k=0; k<n; ++k){
+    gsl_vector_swap_elements(x,k,solutore->pivot[k]);
+    const double x_k=gsl_vector_get(x,k);
+    const size_t ultimaRiga=GSL_MIN(n-1,k+kl);
+    for(size_t i=k+1; i<=ultimaRiga; ++i) gsl_vector_set(x,i,gsl_vector_get(x,i)-LU_BANDA(i,k)*x_k);
+  }
+  for(size_t i=n; i-- > 0;){
+    double somma=gsl_vector_get(x,i);
+    const size_t ultimaColonna=GSL_MIN(n-1,i+kl+ku);
+    for(size_t j=i+1; j<=ultimaColonna; ++j) somma-=LU_BANDA(i,j)*gsl_vector_get(x,j);
+    gsl_vector_set(x,i,somma/LU_BANDA(i,i));
+  }
+#undef LU_BANDA
+}
+
+//Fattorizzazione incompleta ILU(0) di I-gamma*J, con i fattori limitati alla struttura dello jacobiano.
+//La diagonale e' tenuta a parte perche' la struttura potrebbe non contenerla
+static void FattorizzaSparsa(struct SolutoreImplicito* solutore,double gamma){
+  const size_t* inizioRighe=solutore->info.inizioRighe;
+  const size_t* colonne=solutore->info.colonne;
+  double* fattori=solutore->fattori;
+  double* diagonale=solutore->diagonale;
+  size_t* posizioni=solutore->posizioniRiga;
+  for(size_t i=0; i<solutore->n; ++i){
+    diagonale[i]=1.0;
+    for(size_t p=inizioRighe[i]; p<inizioRighe[i+1]; ++p){
+      fattori[p]=-gamma*solutore->valori[p];
+      if(colonne[p] == i) diagonale[i]+=fattori[p];
+      else posizioni[colonne[p]]=p;
+    }
+    //Eliminazione con le righe precedenti in ordine di colonna, scartando i riempimenti fuori dalla struttura
+    for(size_t p=inizioRighe[i]; p<inizioRighe[i+1] && colonne[p] < i; ++p){
+      const size_t k=colonne[p];
+      const double l= diagonale[k] != 0.0 ? fattori[p]/diagonale[k] : 0.0;
+      fattori[p]=l;
+      for(size_t q=inizioRighe[k]; q<inizioRighe[k+1]; ++q){
+        const size_t j=colonne[q];
+        if(j <= k) continue;
+        if(j == i) diagonale[i]-=l*fattori[q];
+        else if(posizioni[j] != SIZE_MAX) fattori[posizioni[j]]-=l*fattori[q];
+      }
+    }
+    for(size_t p=inizioRighe[i]; p<inizioRighe[i+1]; ++p) posizioni[colonne[p]]=SIZE_MAX;
+  }
+}
+
+//Soluzione in place con i fattori di FattorizzaSparsa
+static void RisolviSparsa(const struct SolutoreImplicito* solutore,gsl_vector* x){
+  const size_t* inizioRighe=solutore->info.inizioRighe;
+  const size_t* colonne=solutore->info.colonne;
+  for(size_t i=0; i<solutore->n; ++i){
+    double somma=gsl_vector_get(x,i);
+    for(size_t p=inizioRighe[i]; p<inizioRighe[i+1] && colonne[p] < i; ++p) somma-=solutore->fattori[p]*gsl_vector_get(x,colonne[p]);
+    gsl_vector_set(x,i,somma);
+  }
+  for(size_t i=solutore->n; i-- > 0;){
+    double somma=gsl_vector_get(x,i);
+    for(size_t p=inizioRighe[i]; p<inizioRighe[i+1]; ++p){
+      if(colonne[p] > i) somma-=solutore->fattori[p]*gsl_vector_get(x,colonne[p]);
+    }
+    gsl_vector_set(x,i, solutore->diagonale[i] != 0.0 ? somma/solutore->diagonale[i] : somma);
+  }
+}
+
+//Fattorizzazione della matrice di iterazione I-gamma*J, per JacobianoSparso solo il precondizionatore e per JacobianoLibero nulla
+static void FattorizzaIterazione(struct SolutoreImplicito* solutore,double gamma){
+  int segno;
+  solutore->gammaFattorizzato=gamma;
+  switch(solutore->info.struttura){
+    case JacobianoDenso:
+      gsl_matrix_memcpy(solutore->LU,solutore->J);
+      gsl_matrix_scale(solutore->LU,-gamma);
+      gsl_matrix_add_diagonal(solutore->LU,1.0);
+      gsl_linalg_LU_decomp(solutore->LU,solutore->permutazione,&segno);
+      break;
+    case JacobianoBanda:
+      FattorizzaBanda(solutore,gamma);
+      break;
+    case JacobianoSparso:
+      FattorizzaSparsa(solutore,gamma);
+      break;
+    case JacobianoLibero:
+      return;
+  }
+  if(solutore->statistiche) ++(solutore->statistiche->fattorizzazioni);
+}
+
+//w = P*(I-gamma*J)*v con P l'inversa della fattorizzazione incompleta di JacobianoSparso, per JacobianoLibero J*v e' alle differenze finite nello stato corrente
+static void ProdottoIterazione(struct SolutoreImplicito* solutore,double gamma,const gsl_vector* v,gsl_vector* w){
+  if(solutore->info.struttura == JacobianoSparso){
+    const size_t* inizioRighe=solutore->info.inizioRighe;
+    const size_t* colonne=solutore->info.colonne;
+    for(size_t i=0; i<solutore->n; ++i){
+      double somma=0.0;
+      for(size_t p=inizioRighe[i]; p<inizioRighe[i+1]; ++p) somma+=solutore->valori[p]*gsl_vector_get(v,colonne[p]);
+      gsl_vector_set(w,i,gsl_vector_get(v,i)-gamma*somma);
+    }
+    RisolviSparsa(solutore,w);
+    return;
+  }
+  const double normaV=gsl_blas_dnrm2(v);
+  gsl_vector_memcpy(w,v);
+  if(normaV == 0.0) return;
+  const double epsilon=sqrt(GSL_DBL_EPSILON)*(1.0+gsl_blas_dnrm2(solutore->y))/normaV;
+  gsl_vector_memcpy(solutore->perturbato,solutore->y);
+  gsl_blas_daxpy(epsilon,v,solutore->perturbato);
+  ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,solutore->t,solutore->perturbato,solutore->fPerturbato);
+  gsl_vector_sub(solutore->fPerturbato,solutore->f);
+  gsl_blas_daxpy(-gamma/epsilon,solutore->fPerturbato,w);
+}
+
+//GMRES con riavvio per (I-gamma*J)*x = x, x contiene il termine noto e viene sostituito dalla soluzione
+static void GMRES(struct SolutoreImplicito* solutore,double gamma,gsl_vector* x){
+  const size_t m=solutore->info.dimensioneKrylov;
+  const unsigned maxRiavvii=10;
+  gsl_matrix* H=solutore->H;
+  gsl_vector* g=solutore->g;
+  gsl_vector* b=solutore->b;
+  gsl_vector* w=solutore->w;
+  double* rotazioni=solutore->rotazioni->data;
+
+  gsl_vector_memcpy(b,x);
+  if(solutore->info.struttura == JacobianoSparso) RisolviSparsa(solutore,b);
+  gsl_vector_set_zero(x);
+  double beta=gsl_blas_dnrm2(b);
+  const double soglia=solutore->info.tolleranzaKrylov*beta;
+  gsl_vector_view V_0=gsl_matrix_row(solutore->V,0);
+  gsl_vector_memcpy(&(V_0.vector),b);
+
+  for(unsigned riavvio=0; riavvio<maxRiavvii && beta > soglia; ++riavvio){
+    gsl_vector_scale(&(V_0.vector),1.0/beta);
+    gsl_vector_set_zero(g);
+    gsl_vector_set(g,0,beta);
+    double residuo=beta;
+    size_t k=0;
+    while(k < m && residuo > soglia){
+      gsl_vector_view V_k=gsl_matrix_row(solutore->V,k);
+      ProdottoIterazione(solutore,gamma,&(V_k.vector),w);
+      //Gram-Schmidt modificato
+      for(size_t i=0; i<=k; ++i){
+        gsl_vector_view V_i=gsl_matrix_row(solutore->V,i);
+        double h;
+        gsl_blas_ddot(w,&(V_i.vector),&h);
+        gsl_matrix_set(H,i,k,h);
+        gsl_blas_daxpy(-h,&(V_i.vector),w);
+      }
+      const double h_k1=gsl_blas_dnrm2(w);
+
+      //Rotazioni precedenti e nuova rotazione che annulla H(k+1,k)
+      for(size_t i=0; i<k; ++i){
+        double a=gsl_matrix_get(H,i,k), c=gsl_matrix_get(H,i+1,k);
+        gsl_matrix_set(H,i,k,rotazioni[2*i]*a+rotazioni[2*i+1]*c);
+        gsl_matrix_set(H,i+1,k,-rotazioni[2*i+1]*a+rotazioni[2*i]*c);
+      }
+      const double h_kk=gsl_matrix_get(H,k,k);
+      const double r=hypot(h_kk,h_k1);
+      rotazioni[2*k]= r > 0.0 ? h_kk/r : 1.0;
+      rotazioni[2*k+1]= r > 0.0 ? h_k1/r : 0.0;
+      gsl_matrix_set(H,k,k,r);
+      gsl_matrix_set(H,k+1,k,0.0);
+      const double g_k=gsl_vector_get(g,k);
+      gsl_vector_set(g,k,rotazioni[2*k]*g_k);
+      gsl_vector_set(g,k+1,-rotazioni[2*k+1]*g_k);
+      residuo=fabs(gsl_vector_get(g,k+1));
+      ++k;
+      if(solutore->statistiche) ++(solutore->statistiche->iterazioniLineari);
+      //Con h_k1 nullo la base contiene gia' la soluzione esatta
+      if(h_k1 == 0.0) break;
+      gsl_vector_view V_k1=gsl_matrix_row(solutore->V,k);
+      gsl_vector_memcpy(&(V_k1.vector),w);
+      gsl_vector_scale(&(V_k1.vector),1.0/h_k1);
+    }
+
+    //Sostituzione all'indietro sul sistema triangolare e aggiornamento della soluzione
+    for(size_t i=k; i-- > 0;){
+      double somma=gsl_vector_get(g,i);
+      for(size_t l=i+1; l<k; ++l) somma-=gsl_matrix_get(H,i,l)*gsl_vector_get(g,l);
+      const double h_ii=gsl_matrix_get(H,i,i);
+      gsl_vector_set(g,i, h_ii != 0.0 ? somma/h_ii : 0.0);
+    }
+    for(size_t i=0; i<k; ++i){
+      gsl_vector_view V_i=gsl_matrix_row(solutore->V,i);
+      gsl_blas_daxpy(gsl_vector_get(g,i),&(V_i.vector),x);
+    }
+    if(residuo <= soglia || k < m) break;
+
+    //Residuo vero per il riavvio
+    ProdottoIterazione(solutore,gamma,x,&(V_0.vector));
+    gsl_vector_scale(&(V_0.vector),-1.0);
+    gsl_vector_add(&(V_0.vector),b);
+    beta=gsl_blas_dnrm2(&(V_0.vector));
+  }
+}
+
+//Soluzione in place di (I-gamma*J)*x = x con la fattorizzazione o il metodo iterativo della struttura dello jacobiano
+static void RisolviLineare(struct SolutoreImplicito* solutore,double gamma,gsl_vector* x){
+  switch(solutore->info.struttura){
+    case JacobianoDenso:
+      gsl_linalg_LU_svx(solutore->LU,solutore->permutazione,x);
+      break;
+    case JacobianoBanda:
+      RisolviBanda(solutore,x);
+      break;
+    default:
+      GMRES(solutore,gamma,x);
+  }
+}
+
+//Norma della correzione in delta per il test di convergenza, pesata come l'errore locale se il metodo specifica le tolleranze
+static double NormaCorrezione(const struct SolutoreImplicito* solutore,const gsl_vector* y){
+  if(solutore->tolleranzaAssoluta > 0.0 || solutore->tolleranzaRelativa > 0.0) return NormaErrore(solutore->delta,y,y,solutore->tolleranzaAssoluta,solutore->tolleranzaRelativa);
+  return gsl_blas_dnrm2(solutore->delta);
+}
+
+static bool IterazioniPuntoFisso(struct SolutoreImplicito* solutore,double t,double gamma,const gsl_vector* r,gsl_vector* y){
+  double errore=GSL_POSINF, errorePrecedente=GSL_POSINF;
+  unsigned j=1;
+  while(errore >= solutore->info.tolleranza && j <= solutore->info.maxIterazioni){
+    ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,t,y,solutore->f);
+    gsl_vector_scale(solutore->f,gamma);
+    gsl_vector_add(solutore->f,r);
+    gsl_vector_memcpy(solutore->delta,y);
+    gsl_vector_memcpy(y,solutore->f);
+    
+    //Uso delta per il calcolo dell'errore
+    gsl_vector_sub(solutore->delta,solutore->f);
+    errore=NormaCorrezione(solutore,y);
+    if(j > 1 && errorePrecedente > 0.0) solutore->contrazione=errore/errorePrecedente;
+    errorePrecedente=errore;
+    ++j;
+  }
+  if(solutore->statistiche) solutore->statistiche->iterazioni+=j-1;
+  return errore < solutore->info.tolleranza;
+}
+
+static bool IterazioniNewton(struct SolutoreImplicito* solutore,double t,double gamma,const gsl_vector* r,gsl_vector* y){
+  double normaPrecedente=GSL_POSINF;
+  for(unsigned j=1; j <= solutore->info.maxIterazioni; ++j){
+    if(solutore->statistiche) ++(solutore->statistiche->iterazioni);
+    //Residuo r + gamma*f(t,y) - y e correzione (I-gamma*J)*delta = residuo
+    ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,t,y,solutore->f);
+    gsl_vector_memcpy(solutore->delta,r);
+    gsl_blas_daxpy(gamma,solutore->f,solutore->delta);
+    gsl_vector_sub(solutore->delta,y);
+    solutore->y=y;
+    solutore->t=t;
+    RisolviLineare(solutore,gamma,solutore->delta);
+    gsl_vector_add(y,solutore->delta);
+    
+    double norma=NormaCorrezione(solutore,y);
+    if(norma < solutore->info.tolleranza || gsl_blas_dnrm2(solutore->delta) <= 10.0*GSL_DBL_EPSILON*gsl_blas_dnrm2(y)) return true;
+    //Convergenza troppo lenta o divergenza, conviene aggiornare lo jacobiano
+    if(j > 1 && normaPrecedente > 0.0) solutore->contrazione=norma/normaPrecedente;
+    if(norma > solutore->info.contrazioneMax*normaPrecedente || !gsl_finite(norma)) return false;
+    normaPrecedente=norma;
+  }
+  return false;
+}
+
+static bool RisolviNewton(struct SolutoreImplicito* solutore,double t,double gamma,const gsl_vector* r,gsl_vector* y){
+  //Newton semplificato, si riparte con lo jacobiano aggiornato solo se quello riusato non converge
+  gsl_vector_memcpy(solutore->iniziale,y);
+  bool jacobianoAggiornato=false;
+  while(true){
+    if(!solutore->jacobianoValido){
+      AggiornaJacobiano(solutore,t,y,NULL);
+      jacobianoAggiornato=true;
+    }
+    //Con una fattorizzazione per un gamma vicino l'iterazione resta di Newton semplificato e converge comunque
+    if(!(fabs(gamma-solutore->gammaFattorizzato) <= solutore->variazioneGamma*fabs(gamma))) FattorizzaIterazione(solutore,gamma);
+    if(IterazioniNewton(solutore,t,gamma,r,y)) return true;
+    if(jacobianoAggiornato || solutore->info.struttura == JacobianoLibero) return false;
+    gsl_vector_memcpy(y,solutore->iniziale);
+    solutore->jacobianoValido=false;
+  }
+}
+
+bool RisolviImplicito(struct SolutoreImplicito* solutore,double t,double gamma,const gsl_vector* r,gsl_vector* y){
+  solutore->contrazione=0.0;
+  bool convergenza= solutore->info.metodo == PuntoFisso ? IterazioniPuntoFisso(solutore,t,gamma,r,y) : RisolviNewton(solutore,t,gamma,r,y);
+  if(!convergenza){
+    if(solutore->statistiche) ++(solutore->statistiche->passiNonConvergenti);
+    TRACCIA("ode: equazione implicita non convergente t=%.17g gamma=%.17g\n",t,gamma);
+  }
+  return convergenza;
+}
+
+void SolutoreLinearizzatoInit(struct SolutoreImplicito* solutore,struct InfoBaseSimulazione* infoSimulazione,size_t n){
+  //Gli stessi buffer di Newton, qualunque sia il metodo richiesto per le equazioni implicite
+  struct InfoImplicito implicito={Newton,NULL,0.0,0,0.0,JacobianoDenso,0,0,NULL,NULL,0.0,0,NULL};
+  if(infoSimulazione->implicito) implicito=*(infoSimulazione->implicito);
+  implicito.metodo=Newton;
+  struct InfoBaseSimulazione infoNewton=*infoSimulazione;
+  infoNewton.implicito=&implicito;
+  SolutoreImplicitoInit(solutore,&infoNewton,n);
+  solutore->infoSimulazione=infoSimulazione;
+}
+
+void LinearizzaImplicito(struct SolutoreImplicito* solutore,double t,gsl_vector* y,double gamma){
+  ChiamaDinamica(solutore->infoSimulazione,solutore->statistiche,t,y,solutore->f);
+  solutore->y=y;
+  solutore->t=t;
+  AggiornaJacobiano(solutore,t,y,solutore->f);
+  FattorizzaIterazione(solutore,gamma);
+}
+
+void RisolviLinearizzato(struct SolutoreImplicito* solutore,double gamma,gsl_vector* x){
+  RisolviLineare(solutore,gamma,x);
+}
+
+double NormaJacobiano(const struct SolutoreImplicito* solutore){
+  if(!solutore->jacobianoValido) return GSL_NAN;
+  const size_t n=solutore->n;
+  double norma=0.0;
+  switch(solutore->info.struttura){
+    case JacobianoDenso:
+      for(size_t i=0; i<n; ++i){
+        double somma=0.0;
+        for(size_t j=0; j<n; ++j) somma+=fabs(gsl_matrix_get(solutore->J,i,j));
+        norma=GSL_MAX(norma,somma);
+      }
+      break;
+    case JacobianoBanda:{
+      const size_t kl=solutore->info.bandaInferiore, ku=solutore->info.bandaSuperiore;
+      for(size_t i=0; i<n; ++i){
+        double somma=0.0;
+        const size_t ultima=GSL_MIN(n-1,i+ku);
+        for(size_t j= i > kl ? i-kl : 0; j<=ultima; ++j) somma+=fabs(gsl_matrix_get(solutore->J,i,j+kl-i));
+        norma=GSL_MAX(norma,somma);
+      }
+      break;
+    }
+    case JacobianoSparso:
+      for(size_t i=0; i<n; ++i){
+        double somma=0.0;
+        for(size_t p=solutore->info.inizioRighe[i]; p<solutore->info.inizioRighe[i+1]; ++p) somma+=fabs(solutore->valori[p]);
+        norma=GSL_MAX(norma,somma);
+      }
+      break;
+    case JacobianoLibero:
+      return GSL_NAN;
+  }
+  return norma;
+}
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <math.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//Dati condivisi dai blocchi di membri dell'insieme
+struct CalcoloInsieme{
+  struct InfoBaseSimulazione* infoSimulazione;
+  struct InfoInsieme* infoInsieme;
+  const double* A_Butcher;
+  const double* B_Butcher;
+  unsigned stadi;
+  gsl_matrix* statiIniziali;
+  gsl_matrix** O_sim;
+  size_t dimensioneBlocco;
+  struct Statistiche* statisticheBlocchi; //Statistiche di ogni blocco, sommate alla fine del calcolo. nullptr se non richieste
+};
+
+//Dinamica di un blocco di membri, con la dinamica singola si valutano solo i membri attivi e con quella a blocchi tutti
+static void DinamicaBlocco(struct CalcoloInsieme* calcolo,struct Statistiche* statistiche,double t,gsl_matrix* stati,gsl_matrix* derivate,size_t primoMembro,const bool* attivo){
+  if(calcolo->infoInsieme->dinamica){
+    const double inizio= statistiche ? Orologio() : 0.0;
+    calcolo->infoInsieme->dinamica(t,stati,derivate,primoMembro);
+    if(statistiche){
+      statistiche->tempoDinamica+=Orologio()-inizio;
+      statistiche->chiamateDinamica+=stati->size2;
+    }
+    return;
+  }
+  if(calcolo->infoSimulazione->dinamicaBlocco){
+    ChiamaDinamicaBlocco(calcolo->infoSimulazione,statistiche,t,stati,derivate);
+    return;
+  }
+  for(size_t m=0; m<stati->size2; ++m){
+    if(!attivo[m]) continue;
+    gsl_vector_view x_m=gsl_matrix_column(stati,m);
+    gsl_vector_view f_m=gsl_matrix_column(derivate,m);
+    ChiamaDinamica(calcolo->infoSimulazione,statistiche,t,&(x_m.vector),&(f_m.vector));
+  }
+}
+
+//Y += alpha*X su tutti i membri del blocco, le righe sono contigue e il ciclo interno si vettorizza
+static void CombinaBlocco(gsl_matrix* Y,double alpha,const gsl_matrix* X){
+  const size_t membri=Y->size2;
+  for(size_t i=0; i<Y->size1; ++i){
+    double* y=gsl_matrix_ptr(Y,i,0);
+    const double* x=gsl_matrix_const_ptr(X,i,0);
+    for(size_t m=0; m<membri; ++m) y[m]+=alpha*x[m];
+  }
+}
+
+static void RungeKuttaBlocco(size_t blocco,void* dati){
+  struct CalcoloInsieme* calcolo=(struct CalcoloInsieme*)dati;
+  struct InfoBaseSimulazione* infoSimulazione=calcolo->infoSimulazione;
+  struct InfoInsieme* infoInsieme=calcolo->infoInsieme;
+  const unsigned stadi=calcolo->stadi;
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
+  const size_t n=calcolo->statiIniziali->size1;
+  const size_t primo=blocco*calcolo->dimensioneBlocco;
+  const size_t membri=GSL_MIN(calcolo->dimensioneBlocco,calcolo->statiIniziali->size2-primo);
+  struct Statistiche* statistiche= calcolo->statisticheBlocchi ? calcolo->statisticheBlocchi+blocco : NULL;
+  
+  //Stati in disposizione SoA: la riga i contiene la componente i di tutti i membri del blocco
+  gsl_matrix* Y=gsl_matrix_alloc(n,membri);
+  gsl_matrix* Y_j=gsl_matrix_alloc(n,membri);
+  gsl_matrix* K=gsl_matrix_calloc(stadi*n,membri);
+  gsl_matrix_const_view iniziali=gsl_matrix_const_submatrix(calcolo->statiIniziali,0,primo,n,membri);
+  gsl_matrix_memcpy(Y,&(iniziali.matrix));
+  bool attivo[membri];
+  for(size_t m=0; m<membri; ++m) attivo[m]=true;
+  size_t attivi=membri;
+  
+  double C_vec[stadi];
+  for(unsigned j=0; j<stadi; ++j){
+    C_vec[j]=0.0;
+    for(unsigned l=0; l<stadi; ++l) C_vec[j]+=calcolo->A_Butcher[j*stadi+l];
+  }
+  
+  double t_k_1=infoSimulazione->t0;
+  size_t k=1;
+  for(;k < NumeroCampioni; ++k){
+    //Terminazione dei singoli membri
+    if(infoSimulazione->condizione || infoSimulazione->condizioneParametri){
+      for(size_t m=0; m<membri; ++m){
+        if(!attivo[m]) continue;
+        gsl_vector_view O_k_1=gsl_matrix_column(Y,m);
+        if(!VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector))) continue;
+        attivo[m]=false;
+        --attivi;
+        if(infoInsieme->tCondizione) infoInsieme->tCondizione[primo+m]=t_k_1;
+        if(infoInsieme->indiceCondizione) infoInsieme->indiceCondizione[primo+m]=k-1;
+      }
+    }
+    if(attivi == 0) break;
+    
+    //Calcolo dei K, i coefficienti nulli della tabella vengono saltati
+    for(unsigned j=0; j<stadi; ++j){
+      gsl_matrix_memcpy(Y_j,Y);
+      for(unsigned l=0; l<j; ++l){
+        double a_jl=calcolo->A_Butcher[j*stadi+l];
+        if(a_jl == 0.0) continue;
+        gsl_matrix_const_view K_l=gsl_matrix_const_submatrix(K,l*n,0,n,membri);
+        CombinaBlocco(Y_j,infoSimulazione->h*a_jl,&(K_l.matrix));
+      }
+      gsl_matrix_view K_j=gsl_matrix_submatrix(K,j*n,0,n,membri);
+      DinamicaBlocco(calcolo,statistiche,t_k_1+infoSimulazione->h*C_vec[j],Y_j,&(K_j.matrix),primo,attivo);
+    }
+    
+    //Calcolo passo successivo
+    for(unsigned j=0; j<stadi; ++j){
+      if(calcolo->B_Butcher[j] == 0.0) continue;
+      gsl_matrix_const_view K_j=gsl_matrix_const_submatrix(K,j*n,0,n,membri);
+      CombinaBlocco(Y,infoSimulazione->h*calcolo->B_Butcher[j],&(K_j.matrix));
+    }
+    t_k_1 = infoSimulazione->t0+((double)k)*infoSimulazione->h;
+    
+    for(size_t m=0; m<membri; ++m){
+      if(!attivo[m]) continue;
+      gsl_vector_view y_m=gsl_matrix_column(Y,m);
+      gsl_vector_view O_k=StatoRisultato(calcolo->O_sim[primo+m],k,infoSimulazione->disposizione);
+      gsl_vector_memcpy(&(O_k.vector),&(y_m.vector));
+    }
+  }
+  
+  //Membri arrivati alla fine dell'intervallo
+  for(size_t m=0; m<membri; ++m){
+    if(!attivo[m]) continue;
+    if(infoInsieme->tCondizione) infoInsieme->tCondizione[primo+m]=t_k_1;
+    if(infoInsieme->indiceCondizione) infoInsieme->indiceCondizione[primo+m]=k-1;
+  }
+  if(statistiche) statistiche->passi=k-1;
+  gsl_matrix_free(Y);
+  gsl_matrix_free(Y_j);
+  gsl_matrix_free(K);
+}
+
+gsl_matrix** RungeKuttaEsplicitoInsieme(struct InfoBaseSimulazione* infoSimulazione,struct InfoInsieme* infoInsieme,const double* A_Butcher,const double* B_Butcher,const unsigned stadi,gsl_matrix* statiIniziali){
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t n=statiIniziali->size1;
+  const size_t M=statiIniziali->size2;
+  
+  //Allocazione delle matrici dei membri e inserimento degli stati iniziali
+  gsl_matrix** O_sim=(gsl_matrix**)malloc(M*sizeof(gsl_matrix*));
+  for(size_t m=0; m<M; ++m){
+    O_sim[m]=AllocaRisultato(n,NumeroCampioni,infoSimulazione->disposizione);
+    gsl_matrix_set_zero(O_sim[m]);
+    gsl_vector_view O_0=StatoRisultato(O_sim[m],0,infoSimulazione->disposizione);
+    gsl_vector_const_view iniziale=gsl_matrix_const_column(statiIniziali,m);
+    gsl_vector_memcpy(&(O_0.vector),&(iniziale.vector));
+  }
+  
+  struct CalcoloInsieme calcolo={
+    .infoSimulazione=infoSimulazione,
+    .infoInsieme=infoInsieme,
+    .A_Butcher=A_Butcher,
+    .B_Butcher=B_Butcher,
+    .stadi=stadi,
+    .statiIniziali=statiIniziali,
+    .O_sim=O_sim,
+    .dimensioneBlocco= infoInsieme->dimensioneBlocco ? infoInsieme->dimensioneBlocco : 64,
+    .statisticheBlocchi=NULL
+  };
+  const size_t blocchi=(M+calcolo.dimensioneBlocco-1)/calcolo.dimensioneBlocco;
+  struct Statistiche* statistiche=infoSimulazione->statistiche;
+  if(statistiche) calcolo.statisticheBlocchi=(struct Statistiche*)calloc(blocchi,sizeof(struct Statistiche));
+  EseguiInParallelo(infoInsieme->numeroThread,blocchi,RungeKuttaBlocco,&calcolo);
+  
+  //Ogni blocco ha le sue statistiche per non condividerle tra i thread, i passi sono quelli del blocco piu' lungo
+  if(statistiche){
+    size_t passi=0;
+    for(size_t b=0; b<blocchi; ++b){
+      statistiche->chiamateDinamica+=calcolo.statisticheBlocchi[b].chiamateDinamica;
+      statistiche->tempoDinamica+=calcolo.statisticheBlocchi[b].tempoDinamica;
+      passi=GSL_MAX(passi,calcolo.statisticheBlocchi[b].passi);
+    }
+    free(calcolo.statisticheBlocchi);
+    StatisticheFine(statistiche,inizioCalcolo,passi);
+  }
+  return O_sim;
+}
+
+gsl_matrix** HeunInsieme(struct InfoBaseSimulazione* infoSimulazione,struct InfoInsieme* infoInsieme,gsl_matrix* statiIniziali){
+  static const double A_Heun[4]={0.0,0.0,1.0,0.0};
+  static const double B_Heun[2]={0.5,0.5};
+  return RungeKuttaEsplicitoInsieme(infoSimulazione,infoInsieme,A_Heun,B_Heun,2,statiIniziali);
+}
+
+void LiberaInsieme(gsl_matrix** O_sim,size_t membri){
+  for(size_t m=0; m<membri; ++m) gsl_matrix_free(O_sim[m]);
+  free(O_sim);
+}
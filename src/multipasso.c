@@ -0,0 +1,416 @@
+#include <math.h>
+#include <gsl/gsl_blas.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+#define OrdineMaxAdams 12
+#define OrdineMaxBDF 5
+//Con la famiglia Automatica: soglie sulla stima della rigidita' gamma*rho e passi consecutivi oltre le soglie prima di cambiare famiglia
+#define SogliaRigidita 0.5
+#define SogliaNonRigidita 0.1
+#define PassiRigidita 15
+#define ValutazioniNonRigidita 5
+//Fallimenti consecutivi del correttore dopo i quali il calcolo termina, MXNCF di LSODE
+#define MassimoNonConvergenze 10
+
+//Coefficienti dei metodi in forma di Nordsieck per ordine q (Hindmarsh, routine CFODE di LSODE):
+//el[q][0..q] sono i coefficienti del correttore, tesco[q][0..2] le costanti di errore per gli ordini q-1, q e q+1
+struct CoefficientiNordsieck{
+  double el[OrdineMaxAdams+1][OrdineMaxAdams+1];
+  double tesco[OrdineMaxAdams+2][3];
+};
+
+static void CalcolaCoefficienti(enum FamigliaMultipasso famiglia,struct CoefficientiNordsieck* c){
+  double pc[OrdineMaxAdams+1];
+  memset(c,0,sizeof(struct CoefficientiNordsieck));
+  pc[0]=1.0;
+  if(famiglia == Adams){
+    //pc contiene i coefficienti del polinomio (x+1)(x+2)...(x+q-1)
+    c->el[1][0]=1.0;
+    c->el[1][1]=1.0;
+    c->tesco[1][1]=2.0;
+    c->tesco[2][0]=1.0;
+    double rqfac=1.0;
+    for(unsigned q=2; q<=OrdineMaxAdams; ++q){
+      const double rq1fac=rqfac, qm1=(double)(q-1);
+      rqfac/=(double)q;
+      pc[q-1]=0.0;
+      for(unsigned i=q-1; i>=1; --i) pc[i]=pc[i-1]+qm1*pc[i];
+      pc[0]*=qm1;
+      //Integrali in [-1,0] del polinomio e del polinomio per x
+      double pint=pc[0], xpin=pc[0]/2.0, segno=1.0;
+      for(unsigned i=2; i<=q; ++i){
+        segno=-segno;
+        pint+=segno*pc[i-1]/(double)i;
+        xpin+=segno*pc[i-1]/(double)(i+1);
+      }
+      c->el[q][0]=pint*rq1fac;
+      c->el[q][1]=1.0;
+      for(unsigned i=2; i<=q; ++i) c->el[q][i]=rq1fac*pc[i-1]/(double)i;
+      const double ragq=1.0/(rqfac*xpin);
+      c->tesco[q][1]=ragq;
+      if(q < OrdineMaxAdams) c->tesco[q+1][0]=ragq*rqfac/(double)(q+1);
+      c->tesco[q-1][2]=ragq;
+    }
+  }else{
+    //pc contiene i coefficienti del polinomio (x+1)(x+2)...(x+q)
+    double rq1fac=1.0;
+    for(unsigned q=1; q<=OrdineMaxBDF; ++q){
+      const double fq=(double)q;
+      pc[q]=0.0;
+      for(unsigned i=q; i>=1; --i) pc[i]=pc[i-1]+fq*pc[i];
+      pc[0]*=fq;
+      for(unsigned i=0; i<=q; ++i) c->el[q][i]=pc[i]/pc[1];
+      c->el[q][1]=1.0;
+      c->tesco[q][0]=rq1fac;
+      c->tesco[q][1]=(double)(q+1)/c->el[q][0];
+      c->tesco[q][2]=(double)(q+2)/c->el[q][0];
+      rq1fac/=fq;
+    }
+  }
+}
+
+//Predittore: z <- z*P con P matrice di Pascal, cioe' lo sviluppo di Taylor della storia fino a t+h
+static void PrediciNordsieck(gsl_matrix* z,unsigned q){
+  for(unsigned j=1; j<=q; ++j){
+    for(unsigned i=q-j; i<q; ++i){
+      gsl_vector_view z_i=gsl_matrix_row(z,i);
+      gsl_vector_view z_i1=gsl_matrix_row(z,i+1);
+      gsl_vector_add(&(z_i.vector),&(z_i1.vector));
+    }
+  }
+}
+
+//Annulla la predizione dopo un passo rifiutato, con la stessa sequenza di somme cambiate di segno
+static void RipristinaNordsieck(gsl_matrix* z,unsigned q){
+  for(unsigned j=1; j<=q; ++j){
+    for(unsigned i=q-j; i<q; ++i){
+      gsl_vector_view z_i=gsl_matrix_row(z,i);
+      gsl_vector_view z_i1=gsl_matrix_row(z,i+1);
+      gsl_vector_sub(&(z_i.vector),&(z_i1.vector));
+    }
+  }
+}
+
+//Cambio del passo da h a rh*h, la colonna j contiene h^j*y^(j)/j! quindi viene scalata per rh^j
+static void RiscalaNordsieck(gsl_matrix* z,unsigned q,double rh){
+  double r=1.0;
+  for(unsigned j=1; j<=q; ++j){
+    r*=rh;
+    gsl_vector_view z_j=gsl_matrix_row(z,j);
+    gsl_vector_scale(&(z_j.vector),r);
+  }
+}
+
+//Fattore del passo che porterebbe a 1 l'errore stimato d con esponente 1/(ordine+1), con il margine di LSODE
+static double FattoreNordsieck(double d,double esponente,double margine){
+  return 1.0/(margine*pow(d,esponente)+1e-6*margine);
+}
+
+//Registra il cambio di famiglia, solo i primi massimoCambi vengono memorizzati
+static void RegistraCambio(struct InfoMultipasso* infoMultipasso,double t,size_t passo,enum FamigliaMultipasso famiglia,double h,double rigidita){
+  TRACCIA("ode: cambio famiglia -> %s t=%.17g h=%.17g rigidita=%g\n",famiglia == BDF ? "BDF" : "Adams",t,h,rigidita);
+  if(infoMultipasso->cambi && infoMultipasso->numeroCambi < infoMultipasso->massimoCambi){
+    struct CambioFamiglia cambio={t,passo,famiglia,h,rigidita};
+    infoMultipasso->cambi[infoMultipasso->numeroCambi]=cambio;
+  }
+  ++(infoMultipasso->numeroCambi);
+}
+
+//Se la memoria contiene tutta la traiettoria viene ampliata quando serve e gli istanti accettati vengono restituiti
+static void MultipassoAdattivoCalcolo(struct InfoBaseSimulazione* infoSimulazione,struct InfoMultipasso* infoMultipasso,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,gsl_vector** istanti){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t n=statoIniziale->size;
+  const double tFine=infoSimulazione->t0+infoSimulazione->T;
+  const double tollAss=infoMultipasso->tolleranzaAssoluta, tollRel=infoMultipasso->tolleranzaRelativa;
+  const double hMax= infoMultipasso->hMax > 0.0 ? infoMultipasso->hMax : infoSimulazione->T;
+  //Con Automatica si parte con Adams, i coefficienti di entrambe le famiglie vengono calcolati una volta
+  const bool automatica= infoMultipasso->famiglia == Automatica;
+  enum FamigliaMultipasso famiglia= automatica ? Adams : infoMultipasso->famiglia;
+  const unsigned limiteOrdine= famiglia == BDF ? OrdineMaxBDF : OrdineMaxAdams;
+  const unsigned ordineMaxRichiesto= (infoMultipasso->ordineMax > 0 && infoMultipasso->ordineMax < limiteOrdine) ? infoMultipasso->ordineMax : limiteOrdine;
+  unsigned ordineMax=ordineMaxRichiesto;
+  struct CoefficientiNordsieck coefficientiFamiglie[2];
+  CalcolaCoefficienti(Adams,coefficientiFamiglie);
+  if(automatica || famiglia == BDF) CalcolaCoefficienti(BDF,coefficientiFamiglie+1);
+  const struct CoefficientiNordsieck* coefficienti=coefficientiFamiglie+(famiglia == BDF ? 1 : 0);
+  infoMultipasso->numeroCambi=0;
+
+  //Istanti accettati, la capacita' viene raddoppiata quando serve
+  const bool completa= memoria->finestra == 0;
+  size_t capacita=CampioniRisultato(memoria->O_sim,memoria->disposizione);
+  gsl_vector* t_sim= completa ? gsl_vector_alloc(capacita) : NULL;
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  if(completa) gsl_vector_set(t_sim,0,infoSimulazione->t0);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,statoIniziale);
+
+  //Il correttore y = z_0 + el_0*(h*f(t,y) - z_1) e' l'equazione implicita y = r + gamma*f(t,y) con gamma = el_0*h.
+  //La fattorizzazione viene riusata finche' gamma cambia meno del 30%, le iterazioni sono poche perche' il predittore e' gia' accurato
+  //Con Automatica i buffer di Newton servono per BDF, mentre Adams usa il punto fisso
+  struct SolutoreImplicito solutore;
+  if(automatica){
+    SolutoreLinearizzatoInit(&solutore,infoSimulazione,n);
+    solutore.info.metodo=PuntoFisso;
+  }else{
+    SolutoreImplicitoInit(&solutore,infoSimulazione,n);
+  }
+  solutore.variazioneGamma=0.3;
+  //La convergenza usa la norma pesata del test sull'errore, con tolleranza di un centesimo
+  solutore.tolleranzaAssoluta=tollAss;
+  solutore.tolleranzaRelativa=tollRel;
+  if(infoSimulazione->implicito == NULL || infoSimulazione->implicito->tolleranza <= 0.0) solutore.info.tolleranza=0.01;
+  if(infoSimulazione->implicito == NULL || infoSimulazione->implicito->maxIterazioni == 0) solutore.info.maxIterazioni=4;
+
+  //Storia di Nordsieck: la riga j contiene h^j*y^(j)/j!, la riga q+1 serve per aumentare l'ordine
+  gsl_matrix* z=gsl_matrix_alloc(ordineMax+1,n);
+  gsl_vector* y=gsl_vector_alloc(n);
+  gsl_vector* r=gsl_vector_alloc(n);
+  gsl_vector* correzione=gsl_vector_alloc(n);
+  gsl_vector* correzionePrecedente=gsl_vector_alloc(n);
+  gsl_vector* fInizio= rilevatore.info ? gsl_vector_alloc(n) : NULL;
+  gsl_vector* fFine= rilevatore.info ? gsl_vector_alloc(n) : NULL;
+  gsl_vector_view z_0=gsl_matrix_row(z,0);
+  gsl_vector_view z_1=gsl_matrix_row(z,1);
+
+  //Avvio automatico all'ordine 1 dal solo stato iniziale
+  gsl_vector_memcpy(&(z_0.vector),statoIniziale);
+  ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,infoSimulazione->t0,statoIniziale,&(z_1.vector));
+  double h=infoSimulazione->h;
+  if(h <= 0.0) h=StimaPassoIniziale(infoSimulazione,statoIniziale,&(z_1.vector),1,tollAss,tollRel,hMax,y,r);
+  h=GSL_MIN(h,hMax);
+  gsl_vector_scale(&(z_1.vector),h);
+
+  unsigned q=1, attesa=2, fallimenti=0, nonConvergenze=0;
+  unsigned contatoreRigidita=0;
+  double rigidita=0.0;
+  double rMax=1e4;
+  double t_k=infoSimulazione->t0;
+  size_t k=0,passi=0;
+  while(t_k < tFine){
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    //Se è verificata la condizione termino
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k,&(O_k.vector));
+    if(verificaCondizione) break;
+    if(infoMultipasso->maxPassi && passi >= infoMultipasso->maxPassi) break;
+
+    //Ultimo passo allineato con la fine dell'intervallo
+    bool ultimoPasso=false;
+    if(t_k+1.01*h >= tFine){
+      RiscalaNordsieck(z,q,(tFine-t_k)/h);
+      h=tFine-t_k;
+      ultimoPasso=true;
+    }
+    if(rilevatore.info){
+      gsl_vector_memcpy(fInizio,&(z_1.vector));
+      gsl_vector_scale(fInizio,1.0/h);
+    }
+
+    //Predittore e correttore
+    const double* el=coefficienti->el[q];
+    const double t_nuovo= ultimoPasso ? tFine : t_k+h;
+    PrediciNordsieck(z,q);
+    gsl_vector_memcpy(r,&(z_0.vector));
+    gsl_blas_daxpy(-el[0],&(z_1.vector),r);
+    gsl_vector_memcpy(y,&(z_0.vector));
+    bool convergenza=RisolviImplicito(&solutore,t_nuovo,el[0]*h,r,y);
+    ++passi;
+    //Con Adams il rapporto tra le correzioni del punto fisso stima gamma*rho, anche nei passi rifiutati.
+    //Le equazioni risolte con una sola iterazione non danno la stima e non cambiano il contatore
+    if(automatica && famiglia == Adams && solutore.contrazione > 0.0){
+      rigidita=solutore.contrazione;
+      if(rigidita > SogliaRigidita) ++contatoreRigidita;
+      else if(contatoreRigidita > 0) --contatoreRigidita;
+    }
+
+    double rh;
+    if(!convergenza){
+      //Correttore non convergente, si riduce il passo di un fattore 4. Come in LSODE il calcolo termina dopo troppi fallimenti consecutivi
+      RipristinaNordsieck(z,q);
+      if(infoSimulazione->statistiche) ++(infoSimulazione->statistiche->passiRifiutati);
+      if(++nonConvergenze >= MassimoNonConvergenze) break;
+      rh=0.25;
+      rMax=2.0;
+    }else{
+      nonConvergenze=0;
+      //La correzione accumulata e' proporzionale all'errore locale
+      gsl_vector_memcpy(correzione,y);
+      gsl_vector_sub(correzione,&(z_0.vector));
+      gsl_vector_scale(correzione,1.0/el[0]);
+      const double errore=NormaErrore(correzione,&(O_k.vector),y,tollAss,tollRel)/coefficienti->tesco[q][1];
+
+      if(!(errore <= 1.0)){
+        //Passo rifiutato, dopo tre fallimenti si riparte dall'ordine 1 con la dinamica nello stato corrente
+        RipristinaNordsieck(z,q);
+        if(infoSimulazione->statistiche) ++(infoSimulazione->statistiche->passiRifiutati);
+        TRACCIA("ode: %s passo rifiutato t=%.17g h=%.17g ordine=%u errore=%g\n",__func__,t_k,h,q,errore);
+        rMax=2.0;
+        if(++fallimenti >= 3){
+          h*=0.1;
+          q=1;
+          ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k,&(O_k.vector),&(z_1.vector));
+          gsl_vector_scale(&(z_1.vector),h);
+          attesa=5;
+          if(h < infoMultipasso->hMin || t_k+h == t_k) break;
+          continue;
+        }
+        //Con una stima non finita (dinamica NaN) si riduce il passo di un fattore 4
+        rh= gsl_finite(errore) ? FattoreNordsieck(errore,1.0/(double)(q+1),1.2) : 0.25;
+        if(q > 1){
+          gsl_vector_view z_q=gsl_matrix_row(z,q);
+          double rhGiu=FattoreNordsieck(NormaErrore(&(z_q.vector),&(O_k.vector),&(O_k.vector),tollAss,tollRel)/coefficienti->tesco[q][0],1.0/(double)q,1.3);
+          if(rhGiu > rh){
+            rh=GSL_MIN(rhGiu,1.0);
+            --q;
+          }
+        }
+        if(fallimenti >= 2) rh=GSL_MIN(rh,0.2);
+      }else{
+        //Passo accettato, la storia viene corretta con i coefficienti del correttore
+        for(unsigned j=0; j<=q; ++j){
+          gsl_vector_view z_j=gsl_matrix_row(z,j);
+          gsl_blas_daxpy(el[j],correzione,&(z_j.vector));
+        }
+        fallimenti=0;
+        if(completa && k+1 == capacita){
+          memoria->O_sim=RidimensionaRisultato(memoria->O_sim,k+1,2*capacita,memoria->disposizione);
+          t_sim=EspandiIstanti(t_sim,k+1);
+          capacita*=2;
+        }
+        const double t_precedente=t_k;
+        t_k=t_nuovo;
+        ++k;
+        gsl_vector_view O_precedente=StatoMemoria(memoria,k-1);
+        gsl_vector_view O_nuovo=StatoMemoria(memoria,k);
+        gsl_vector_memcpy(&(O_nuovo.vector),&(z_0.vector));
+        if(completa) gsl_vector_set(t_sim,k,t_k);
+        EmettiStato(memoria,k,t_k);
+        TRACCIA_PASSO(k,t_k,h);
+
+        //Dopo la correzione z_1 e' h*f(t_k,y_k), quindi la dinamica agli estremi del passo e' gia' disponibile
+        if(rilevatore.info){
+          gsl_vector_memcpy(fFine,&(z_1.vector));
+          gsl_vector_scale(fFine,1.0/h);
+          if(RilevaEventi(&rilevatore,t_precedente,&(O_precedente.vector),t_k,&(O_nuovo.vector),fInizio,fFine,NULL)) break;
+        }
+
+        //Cambio di famiglia con Automatica: verso BDF quando il punto fisso e' vicino al limite di convergenza per molti passi,
+        //verso Adams quando con lo stesso passo il punto fisso converge rapidamente per diverse valutazioni dello jacobiano
+        if(automatica){
+          enum FamigliaMultipasso nuovaFamiglia=famiglia;
+          if(famiglia == Adams){
+            if(contatoreRigidita >= PassiRigidita) nuovaFamiglia=BDF;
+          }else if(attesa == 1){
+            rigidita=h*coefficientiFamiglie[0].el[q][0]*NormaJacobiano(&solutore);
+            if(rigidita < SogliaNonRigidita){
+              if(++contatoreRigidita >= ValutazioniNonRigidita) nuovaFamiglia=Adams;
+            }else{
+              contatoreRigidita=0;
+            }
+          }
+          if(nuovaFamiglia != famiglia){
+            RegistraCambio(infoMultipasso,t_k,k,nuovaFamiglia,h,rigidita);
+            famiglia=nuovaFamiglia;
+            coefficienti=coefficientiFamiglie+(famiglia == BDF ? 1 : 0);
+            ordineMax= famiglia == BDF ? GSL_MIN(ordineMaxRichiesto,OrdineMaxBDF) : ordineMaxRichiesto;
+            q=GSL_MIN(q,ordineMax);
+            //Lo jacobiano dell'ultimo tratto con BDF puo' essere molto vecchio
+            solutore.info.metodo= famiglia == BDF ? Newton : PuntoFisso;
+            solutore.jacobianoValido=false;
+            solutore.gammaFattorizzato=GSL_NAN;
+            contatoreRigidita=0;
+            attesa=q+1;
+            continue;
+          }
+        }
+
+        //Passo e ordine vengono rivalutati solo dopo q+1 passi con lo stesso passo e ordine
+        if(--attesa > 0){
+          if(attesa == 1 && q < ordineMax) gsl_vector_memcpy(correzionePrecedente,correzione);
+          continue;
+        }
+        double rhStesso=FattoreNordsieck(errore,1.0/(double)(q+1),1.2), rhGiu=0.0, rhSu=0.0;
+        if(q > 1){
+          gsl_vector_view z_q=gsl_matrix_row(z,q);
+          rhGiu=FattoreNordsieck(NormaErrore(&(z_q.vector),&(O_precedente.vector),&(O_nuovo.vector),tollAss,tollRel)/coefficienti->tesco[q][0],1.0/(double)q,1.3);
+        }
+        if(q < ordineMax){
+          gsl_vector_sub(correzionePrecedente,correzione);
+          rhSu=FattoreNordsieck(NormaErrore(correzionePrecedente,&(O_precedente.vector),&(O_nuovo.vector),tollAss,tollRel)/coefficienti->tesco[q][2],1.0/(double)(q+2),1.4);
+        }
+        unsigned nuovoOrdine=q;
+        rh=rhStesso;
+        if(rhSu > rh && rhSu > rhGiu){
+          nuovoOrdine=q+1;
+          rh=rhSu;
+        }else if(rhGiu > rh){
+          nuovoOrdine=q-1;
+          rh=rhGiu;
+        }
+        if(rh < 1.1){
+          attesa=3;
+          continue;
+        }
+        if(nuovoOrdine > q){
+          gsl_vector_view z_q1=gsl_matrix_row(z,q+1);
+          gsl_vector_memcpy(&(z_q1.vector),correzione);
+          gsl_vector_scale(&(z_q1.vector),el[q]/(double)(q+1));
+        }
+        if(nuovoOrdine != q) TRACCIA("ode: %s ordine %u -> %u t=%.17g\n",__func__,q,nuovoOrdine,t_k);
+        q=nuovoOrdine;
+      }
+    }
+
+    //Cambio del passo con crescita limitata, la storia viene riscalata invece di ricalcolata
+    rh=GSL_MIN(rh,rMax);
+    rh=GSL_MIN(rh,hMax/h);
+    RiscalaNordsieck(z,q,rh);
+    h*=rh;
+    if(convergenza && fallimenti == 0) rMax=10.0;
+    attesa=q+1;
+    //Si termina anche quando il passo non cambia piu' l'istante
+    if(h < infoMultipasso->hMin || t_k+h == t_k) break;
+  }
+
+  //Copia dei soli passi accettati
+  if(completa){
+    memoria->O_sim=RidimensionaRisultato(memoria->O_sim,k+1,k+1,memoria->disposizione);
+    if(istanti){
+      *istanti=gsl_vector_alloc(k+1);
+      gsl_vector_const_view t_usati=gsl_vector_const_subvector(t_sim,0,k+1);
+      gsl_vector_memcpy(*istanti,&(t_usati.vector));
+    }
+    gsl_vector_free(t_sim);
+  }
+
+  gsl_matrix_free(z);
+  gsl_vector_free(y);
+  gsl_vector_free(r);
+  gsl_vector_free(correzione);
+  gsl_vector_free(correzionePrecedente);
+  if(fInizio) gsl_vector_free(fInizio);
+  if(fFine) gsl_vector_free(fFine);
+  SolutoreImplicitoLibera(&solutore);
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,k);
+}
+
+gsl_matrix* MultipassoAdattivo(struct InfoBaseSimulazione* infoSimulazione,struct InfoMultipasso* infoMultipasso,gsl_vector* statoIniziale,gsl_vector** istanti){
+  struct MemoriaRisultato memoria;
+  MemoriaCompletaInit(&memoria,statoIniziale->size,64,infoSimulazione->disposizione);
+  MultipassoAdattivoCalcolo(infoSimulazione,infoMultipasso,statoIniziale,&memoria,istanti);
+  return memoria.O_sim;
+}
+
+int MultipassoAdattivoFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoMultipasso* infoMultipasso,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  struct MemoriaRisultato memoria;
+  MemoriaFlussoInit(&memoria,statoIniziale->size,uscita,infoSimulazione);
+  memoria.intestazione.h=0.0;
+  MultipassoAdattivoCalcolo(infoSimulazione,infoMultipasso,statoIniziale,&memoria,NULL);
+  return MemoriaFlussoChiudi(&memoria);
+}
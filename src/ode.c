@@ -1,187 +1,231 @@
 #include <math.h>
+#include <stdlib.h>
 #include <gsl/gsl_blas.h>
 #include <ode.h> 
+#include "ode_interno.h"
 
-/*! \brief Struttura dati per le informazioni sulla matrice del calcolo
- *
- *  Questa matrice viene scritta sempre all'inizio del file binario per specificare la disposizione del dati nel file
+/*! \brief Buffer dei metodi a passo fisso, allocati nello heap una volta per calcolo o per spazio di lavoro
  */
-struct InfoMatrice{
-  size_t dimensioneStruct; /*!< Dimensione di questa struttura*/
-  size_t righe; /*!< Numero di righe della matrice, ovvero la dimensione dello stato*/
-  size_t colonne; /*!< Numero di colonne della matrice, ovvero numero di passi del calcolo*/
-  double h; /*!< Passo di integrazione*/
-  double T; /*!< Periodo di integrazione*/
-  double t0; /*!< Istante iniziale del calcolo*/
+struct BufferPassoFisso{
+  struct Propagatore propagatore; /*!< Metodo per il quale sono allocati i buffer*/
+  size_t n; /*!< Dimensione dello stato*/
+  gsl_matrix* K; /*!< Stadi per colonne per Runge Kutta e Rosenbrock, le due valutazioni della dinamica per Heun*/
+  gsl_vector* f; /*!< Buffer per la dinamica*/
+  gsl_vector* r; /*!< Termine noto dell'equazione implicita di Crank Nicolson*/
+  double* C; /*!< Coefficienti c_j della tabella di Butcher*/
+  struct SolutoreImplicito solutore; /*!< Risolutore dei metodi impliciti*/
 };
 
-gsl_matrix* EuleroAvanti(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
-  const size_t NumeroCampioni=(size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+static void BufferPassoFissoInit(struct BufferPassoFisso* buffer,struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,size_t n){
+  const unsigned stadi=propagatore->stadi;
+  buffer->propagatore=*propagatore;
+  buffer->n=n;
+  buffer->K=NULL;
+  buffer->f=NULL;
+  buffer->r=NULL;
+  buffer->C=NULL;
+  switch(propagatore->metodo){
+    case PropagatoreEuleroAvanti:
+      buffer->f=gsl_vector_alloc(n);
+      break;
+    case PropagatoreEuleroIndietro:
+      SolutoreImplicitoInit(&(buffer->solutore),infoSimulazione,n);
+      break;
+    case PropagatoreCrankNicolson:
+      buffer->f=gsl_vector_alloc(n);
+      buffer->r=gsl_vector_alloc(n);
+      SolutoreImplicitoInit(&(buffer->solutore),infoSimulazione,n);
+      break;
+    case PropagatoreHeun:
+      buffer->K=gsl_matrix_alloc(n,2);
+      break;
+    case PropagatoreRungeKutta:
+      buffer->K=gsl_matrix_alloc(n,stadi);
+      buffer->f=gsl_vector_alloc(n);
+      //c_j come somma delle righe della tabella
+      buffer->C=(double*)malloc(stadi*sizeof(double));
+      for(unsigned j=0; j<stadi; ++j){
+        buffer->C[j]=0.0;
+        for(unsigned l=0; l<stadi; ++l) buffer->C[j]+=propagatore->A_Butcher[j*stadi+l];
+      }
+      break;
+    case PropagatoreRosenbrockW:
+      buffer->K=gsl_matrix_alloc(n,2);
+      buffer->f=gsl_vector_alloc(n);
+      SolutoreLinearizzatoInit(&(buffer->solutore),infoSimulazione,n);
+      break;
+  }
+}
+
+static void BufferPassoFissoLibera(struct BufferPassoFisso* buffer){
+  if(buffer->K) gsl_matrix_free(buffer->K);
+  if(buffer->f) gsl_vector_free(buffer->f);
+  if(buffer->r) gsl_vector_free(buffer->r);
+  free(buffer->C);
+  const enum MetodoPropagatore metodo=buffer->propagatore.metodo;
+  if(metodo == PropagatoreEuleroIndietro || metodo == PropagatoreCrankNicolson || metodo == PropagatoreRosenbrockW) SolutoreImplicitoLibera(&(buffer->solutore));
+}
+
+static void EuleroAvantiCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
   const size_t n=statoIniziale->size;
-  //Allocazione matrice e inserimento stato iniziale
-  gsl_matrix* O_sim=gsl_matrix_alloc(n,NumeroCampioni);
-  gsl_matrix_set_zero(O_sim);
-  gsl_matrix_set_col(O_sim,0,statoIniziale);
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
   
   //EA
-  double f_Buffer[n];
+  gsl_vector* dy_Buffer=buffer->f;
   double t_k_1=infoSimulazione->t0;
-  gsl_vector_view dy_Buffer=gsl_vector_view_array(f_Buffer,n);
   size_t k=1;
   for(;k < NumeroCampioni; ++k){
-    gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
     //Se è verificata la condizione termino
-    bool verificaCondizione = infoSimulazione->condizione == NULL ? 0 : infoSimulazione->condizione(t_k_1,&(O_k_1.vector));
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
     if(verificaCondizione) break;
     
-    gsl_vector_view O_k=gsl_matrix_column(O_sim,k);
-    gsl_vector_add(&(O_k.vector), &(O_k_1.vector));
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
     
-    infoSimulazione->dinamica(t_k_1,&(O_k_1.vector),&(dy_Buffer.vector));
-    gsl_vector_scale( &(dy_Buffer.vector),infoSimulazione->h );
-    gsl_vector_add( &(O_k.vector), &(dy_Buffer.vector));
-    t_k_1 = infoSimulazione->t0+((double)k)*infoSimulazione->h;
+    ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k_1,&(O_k_1.vector),dy_Buffer);
+    //La dinamica resta non scalata perche' serve agli eventi come pendenza all'inizio del passo
+    gsl_blas_daxpy(infoSimulazione->h,dy_Buffer,&(O_k.vector));
+    const double t_k=infoSimulazione->t0+((double)k)*infoSimulazione->h;
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,infoSimulazione->h);
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),dy_Buffer,NULL,NULL)) break;
+    t_k_1 = t_k;
   }
   
-  //Assegno gli istanti della condizione nel caso sia verificata
-  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
-  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
-  return O_sim;
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
 }
 
-gsl_matrix* EuleroIndietro(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
-  const size_t NumeroCampioni=(size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+static void EuleroIndietroCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
   const size_t n=statoIniziale->size;
   
-  //Allocazione matrice
-  gsl_matrix* O_sim=gsl_matrix_alloc(n,NumeroCampioni);
-  gsl_matrix_set_zero(O_sim);
-  gsl_matrix_set_col(O_sim,0,statoIniziale);
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
   
   //EI
-  double f_Buffer[n], puntoFisso_tmp[n];
-  gsl_vector_view dy_Buffer=gsl_vector_view_array(f_Buffer,n);
-  gsl_vector_view PF_tmp=gsl_vector_view_array(puntoFisso_tmp,n);
+  struct SolutoreImplicito* solutore=&(buffer->solutore);
+  SolutoreImplicitoRiavvia(solutore,infoSimulazione);
   double t_k=infoSimulazione->t0+infoSimulazione->h, t_k_1=infoSimulazione->t0;
   unsigned k=1;
   for(;k < NumeroCampioni; ++k){
-    gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
     //Se è verificata la condizione termino
-    bool verificaCondizione = infoSimulazione->condizione == NULL ? 0 : infoSimulazione->condizione(t_k_1,&(O_k_1.vector));
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
     if(verificaCondizione) break;
     
-    gsl_vector_view O_k=gsl_matrix_column(O_sim,k);
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
     gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
     
-    //Iterazioni di punto fisso
-    double epsilonPF=1e-15,errore=GSL_POSINF;
-    unsigned MAX_ITERS=50;
-    unsigned j=1;
-    while(errore >= epsilonPF && j <= MAX_ITERS){    
-      infoSimulazione->dinamica(t_k,&(O_k.vector),&(dy_Buffer.vector));
-      gsl_vector_scale(&(dy_Buffer.vector),infoSimulazione->h);
-      gsl_vector_add(&(dy_Buffer.vector),&(O_k_1.vector));
-      gsl_vector_memcpy(&(PF_tmp.vector),&(O_k.vector));
-      gsl_vector_memcpy(&(O_k.vector),&(dy_Buffer.vector));
-      
-      //Uso by_Buffer per il calcolo dell'errore
-      gsl_vector_sub(&(PF_tmp.vector),&(dy_Buffer.vector));
-      errore=gsl_blas_dnrm2(&(PF_tmp.vector));
-      ++j;
-    }
+    //Soluzione di O_k = O_k_1 + h*f(t_k,O_k)
+    RisolviImplicito(solutore,t_k,infoSimulazione->h,&(O_k_1.vector),&(O_k.vector));
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,infoSimulazione->h);
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),NULL,NULL,NULL)) break;
     t_k_1=t_k;
     t_k = infoSimulazione->t0+((double)(k+1))*infoSimulazione->h;
   }
-  //Assegno gli istanti della condizione nel caso sia verificata
-  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
-  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
-  return O_sim;
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
 }
 
-gsl_matrix* CrankNicolson(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
-  const size_t NumeroCampioni=(size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+static void CrankNicolsonCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
   const size_t n=statoIniziale->size;
   
-  //Allocazione matrice
-  gsl_matrix* O_sim=gsl_matrix_alloc(n,NumeroCampioni);
-  gsl_matrix_set_zero(O_sim);
-  gsl_matrix_set_col(O_sim,0,statoIniziale);
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
   
   //CN
-  double f_Buffer[n*2], puntoFisso_tmp[n];
-  gsl_matrix_view dy_Buffer=gsl_matrix_view_array(f_Buffer,n,2);
-  gsl_vector_view PF_tmp=gsl_vector_view_array(puntoFisso_tmp,n);
+  gsl_vector* f_k_1=buffer->f;
+  gsl_vector* r_k=buffer->r;
+  struct SolutoreImplicito* solutore=&(buffer->solutore);
+  SolutoreImplicitoRiavvia(solutore,infoSimulazione);
   double t_k=infoSimulazione->t0+infoSimulazione->h,t_k_1=infoSimulazione->t0;
   unsigned k=1;
   for(;k < NumeroCampioni; ++k){
-    gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);    
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);    
     //Se è verificata la condizione termino
-    bool verificaCondizione = infoSimulazione->condizione == NULL ? 0 : infoSimulazione->condizione(t_k_1,&(O_k_1.vector));
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
     if(verificaCondizione) break;
     
-    gsl_vector_view O_k=gsl_matrix_column(O_sim,k);
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
     gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
-    gsl_vector_view f_k_1=gsl_matrix_column(&(dy_Buffer.matrix),0);
-    gsl_vector_view f_k=gsl_matrix_column(&(dy_Buffer.matrix),1);
-    infoSimulazione->dinamica(t_k_1,&(O_k_1.vector),&(f_k_1.vector));
+    ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k_1,&(O_k_1.vector),f_k_1);
     
-    //Iterazioni di punto fisso
-    double epsilonPF=1e-15,errore=GSL_POSINF;
-    unsigned MAX_ITERS=50;
-    unsigned j=1;
-    while(errore >= epsilonPF && j <= MAX_ITERS){    
-      infoSimulazione->dinamica(t_k,&(O_k.vector),&(f_k.vector));
-      gsl_vector_add(&(f_k.vector),&(f_k_1.vector));
-      
-      gsl_vector_scale( &(f_k.vector),(infoSimulazione->h)/2.0 );
-      gsl_vector_add( &(f_k.vector),&(O_k_1.vector));
-      gsl_vector_memcpy(&(PF_tmp.vector),&(O_k.vector));
-      gsl_vector_memcpy(&(O_k.vector),&(f_k.vector));
-      
-      //Uso by_Buffer per il calcolo dell'errore
-      gsl_vector_sub(&(PF_tmp.vector),&(f_k.vector));
-      errore=gsl_blas_dnrm2(&(PF_tmp.vector));
-      ++j;
-    }
+    //Soluzione di O_k = O_k_1 + h/2*f(t_k_1,O_k_1) + h/2*f(t_k,O_k)
+    gsl_vector_memcpy(r_k,&(O_k_1.vector));
+    gsl_blas_daxpy((infoSimulazione->h)/2.0,f_k_1,r_k);
+    RisolviImplicito(solutore,t_k,(infoSimulazione->h)/2.0,r_k,&(O_k.vector));
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,infoSimulazione->h);
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),NULL,NULL,NULL)) break;
     t_k_1=t_k;
     t_k = infoSimulazione->t0+((double)(k+1))*infoSimulazione->h;
   }
-  //Assegno gli istanti della condizione nel caso sia verificata
-  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
-  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
-  return O_sim;
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
 }
 
-gsl_matrix* Heun(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
-  const size_t NumeroCampioni=(size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+static void HeunCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
   const size_t n=statoIniziale->size;
   
-  //Allocazione matrice
-  gsl_matrix* O_sim=gsl_matrix_alloc(n,NumeroCampioni);
-  gsl_matrix_set_zero(O_sim);
-  gsl_matrix_set_col(O_sim,0,statoIniziale);
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
   
   //Heun
-  double f_Buffer[n*2];
-  gsl_matrix_view dy_Buffer=gsl_matrix_view_array(f_Buffer,n,2);
+  gsl_matrix* dy_Buffer=buffer->K;
   double t_k=infoSimulazione->t0+infoSimulazione->h,t_k_1=infoSimulazione->t0;
   unsigned k=1;
   for(;k < NumeroCampioni; ++k){
-    gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
     //Se è verificata la condizione termino
-    bool verificaCondizione = infoSimulazione->condizione == NULL ? 0 : infoSimulazione->condizione(t_k_1,&(O_k_1.vector));
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
     if(verificaCondizione) break;
     
-    gsl_vector_view O_k=gsl_matrix_column(O_sim,k);
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
     gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
-    gsl_vector_view f_k_1=gsl_matrix_column(&(dy_Buffer.matrix),0);
-    gsl_vector_view f_k=gsl_matrix_column(&(dy_Buffer.matrix),1);
-    infoSimulazione->dinamica(t_k_1,&(O_k_1.vector),&(f_k_1.vector));
+    gsl_vector_view f_k_1=gsl_matrix_column(dy_Buffer,0);
+    gsl_vector_view f_k=gsl_matrix_column(dy_Buffer,1);
+    ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k_1,&(O_k_1.vector),&(f_k_1.vector));
     
     //Calcolo EA
     gsl_vector_scale(&(f_k_1.vector),infoSimulazione->h);
     gsl_vector_add(&(O_k.vector),&(f_k_1.vector));
-    infoSimulazione->dinamica(t_k,&(O_k.vector),&(f_k.vector));
+    ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k,&(O_k.vector),&(f_k.vector));
     
     //Calcolo passo successivo
     gsl_vector_scale(&(f_k.vector),infoSimulazione->h);
@@ -189,117 +233,200 @@ gsl_matrix* Heun(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIn
     gsl_vector_scale(&(f_k.vector),5e-1);
     gsl_vector_memcpy(&(O_k.vector),&(O_k_1.vector));
     gsl_vector_add(&(O_k.vector),&(f_k.vector));
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,infoSimulazione->h);
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),NULL,NULL,NULL)) break;
     t_k_1=t_k;
     t_k = infoSimulazione->t0+((double)(k+1))*infoSimulazione->h;
   }
-  //Assegno gli istanti della condizione nel caso sia verificata
-  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
-  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
-  return O_sim;
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
 }
 
-gsl_matrix* RungeKuttaEsplicito(struct InfoBaseSimulazione* infoSimulazione,double* A_Butcher, double* B_Butcher,const unsigned stadi,gsl_vector* statoIniziale){
-  const size_t NumeroCampioni=(size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+static void RungeKuttaEsplicitoCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
   const size_t n=statoIniziale->size;
   
-  //Allocazione matrice
-  gsl_matrix* O_sim=gsl_matrix_alloc(n,NumeroCampioni);
-  gsl_matrix_set_zero(O_sim);
-  gsl_matrix_set_col(O_sim,0,statoIniziale);
-  
-  //RungeKutta
-  double K_mat[n*stadi],C_vec[stadi],f_k_vec[n],uni_vec[stadi];
-  gsl_matrix_view K=gsl_matrix_view_array(K_mat,n,stadi);
-  gsl_vector_view C=gsl_vector_view_array(C_vec,stadi);
-  gsl_vector_view f_k=gsl_vector_view_array(f_k_vec,n);
-  gsl_vector_view uni=gsl_vector_view_array(uni_vec,stadi);
-  gsl_matrix_view A=gsl_matrix_view_array(A_Butcher,stadi,stadi);
-  gsl_vector_view B=gsl_vector_view_array(B_Butcher,stadi);
-  gsl_vector_set_all(&(uni.vector),1.0);
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
   
-  //Ottengo i coefficienti c_j
-  gsl_blas_dgemv(CblasNoTrans,1.0,&(A.matrix),&(uni.vector),0.0,&(C.vector));
+  //RungeKutta, i coefficienti c_j sono gia' nel buffer
+  const unsigned stadi=buffer->propagatore.stadi;
+  gsl_matrix* K=buffer->K;
+  gsl_vector* f_k=buffer->f;
+  gsl_matrix_view A=gsl_matrix_view_array(buffer->propagatore.A_Butcher,stadi,stadi);
+  gsl_vector_view B=gsl_vector_view_array(buffer->propagatore.B_Butcher,stadi);
   
   double t_k=infoSimulazione->t0+infoSimulazione->h,t_k_1=infoSimulazione->t0;
   unsigned k=1;
   for(;k < NumeroCampioni; ++k){
-    gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
     //Se è verificata la condizione termino
-    bool verificaCondizione = infoSimulazione->condizione == NULL ? 0 : infoSimulazione->condizione(t_k_1,&(O_k_1.vector));
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
     if(verificaCondizione) break;
     
-    gsl_vector_view O_k=gsl_matrix_column(O_sim,k);
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
     gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
-    gsl_matrix_set_zero(&(K.matrix));
+    gsl_matrix_set_zero(K);
     
     //Calcolo dei K
     for(unsigned j=0; j<stadi; ++j){
       gsl_vector_view a_j=gsl_matrix_row(&(A.matrix),j);
-      double t_j=t_k_1+(infoSimulazione->h*gsl_vector_get(&(C.vector),j));
+      double t_j=t_k_1+(infoSimulazione->h*buffer->C[j]);
       
-      gsl_blas_dgemv(CblasNoTrans,1.0,&(K.matrix),&(a_j.vector),0.0,&(f_k.vector));
-      gsl_vector_scale(&(f_k.vector),infoSimulazione->h);
-      gsl_vector_add(&(O_k.vector),&(f_k.vector));
-      infoSimulazione->dinamica(t_j,&(O_k.vector),&(f_k.vector));
-      gsl_matrix_set_col(&(K.matrix),j,&(f_k.vector));
+      gsl_blas_dgemv(CblasNoTrans,1.0,K,&(a_j.vector),0.0,f_k);
+      gsl_vector_scale(f_k,infoSimulazione->h);
+      gsl_vector_add(&(O_k.vector),f_k);
+      ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_j,&(O_k.vector),f_k);
+      gsl_matrix_set_col(K,j,f_k);
       
       gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
     }
     
     //Calcolo passo successivo
-    gsl_blas_dgemv(CblasNoTrans,1.0,&(K.matrix),&(B.vector),0.0,&(f_k.vector));
-    gsl_vector_scale(&(f_k.vector),infoSimulazione->h);
-    gsl_vector_add(&(O_k.vector),&(f_k.vector));
+    gsl_blas_dgemv(CblasNoTrans,1.0,K,&(B.vector),0.0,f_k);
+    gsl_vector_scale(f_k,infoSimulazione->h);
+    gsl_vector_add(&(O_k.vector),f_k);
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,infoSimulazione->h);
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),NULL,NULL,NULL)) break;
     t_k_1=t_k;
     t_k = infoSimulazione->t0+((double)(k+1))*infoSimulazione->h;
   }
-  //Assegno gli istanti della condizione nel caso sia verificata
-  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
-  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
-  return O_sim;
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
 }
 
-gsl_matrix* LMM(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco){
-  const size_t NumeroCampioni=(size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+static void RosenbrockWCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
+  const size_t n=statoIniziale->size;
+  
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
+  
+  //ROS2 di Verwer: (I-gamma*h*J)*k1 = f(t_k_1,O_k_1), (I-gamma*h*J)*k2 = f(t_k,O_k_1+h*k1) - 2*k1, O_k = O_k_1 + 3/2*h*k1 + 1/2*h*k2
+  //L'ordine 2 non dipende da J, quindi lo jacobiano puo' essere approssimato e non serve la derivata rispetto al tempo
+  const double h=infoSimulazione->h;
+  const double gamma=(1.0+1.0/sqrt(2.0))*h;
+  gsl_vector_view k1=gsl_matrix_column(buffer->K,0);
+  gsl_vector_view k2=gsl_matrix_column(buffer->K,1);
+  gsl_vector* f_k=buffer->f;
+  struct SolutoreImplicito* solutore=&(buffer->solutore);
+  SolutoreImplicitoRiavvia(solutore,infoSimulazione);
+  double t_k=infoSimulazione->t0+h,t_k_1=infoSimulazione->t0;
+  unsigned k=1;
+  for(;k < NumeroCampioni; ++k){
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
+    //Se è verificata la condizione termino
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
+    if(verificaCondizione) break;
+    
+    //Una sola fattorizzazione per passo, usata da entrambi gli stadi
+    LinearizzaImplicito(solutore,t_k_1,&(O_k_1.vector),gamma);
+    gsl_vector_memcpy(&(k1.vector),solutore->f);
+    RisolviLinearizzato(solutore,gamma,&(k1.vector));
+    
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
+    gsl_blas_daxpy(h,&(k1.vector),&(O_k.vector));
+    ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k,&(O_k.vector),f_k);
+    gsl_vector_memcpy(&(k2.vector),f_k);
+    gsl_blas_daxpy(-2.0,&(k1.vector),&(k2.vector));
+    RisolviLinearizzato(solutore,gamma,&(k2.vector));
+    
+    //Calcolo passo successivo
+    gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
+    gsl_blas_daxpy(1.5*h,&(k1.vector),&(O_k.vector));
+    gsl_blas_daxpy(0.5*h,&(k2.vector),&(O_k.vector));
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,h);
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),solutore->f,NULL,NULL)) break;
+    t_k_1=t_k;
+    t_k = infoSimulazione->t0+((double)(k+1))*h;
+  }
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
+}
+
+static void LMMCalcolo(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco,struct MemoriaRisultato* memoria){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
   const size_t n=innesco->size1;
   const size_t p=innesco->size2-1;
   
-  //Allocazione matrice
-  gsl_matrix* O_sim=gsl_matrix_alloc(n,NumeroCampioni);
-  gsl_matrix_set_zero(O_sim);
-  
   //LMM
-  //Inizializzazione dei buffer
-  double Buffer_O_mat[n*(p+1)],Buffer_F_mat[n*(p+1)],CombA_vec[n],CombB_vec[n],f_1_vec[n],puntoFisso_tmp[n];
+  //Inizializzazione dei buffer, lo stato k e la sua dinamica occupano la colonna k%(p+1) quindi la storia non viene mai spostata
+  double A_vec[p+1],B_vec[p+1];
+  double* Buffer_O_mat=(double*)malloc(n*(p+1)*sizeof(double));
+  double* Buffer_F_mat=(double*)malloc(n*(p+1)*sizeof(double));
+  double* CombA_vec=(double*)malloc(n*sizeof(double));
+  double* CombB_vec=(double*)malloc(n*sizeof(double));
   gsl_matrix_view Buffer_O=gsl_matrix_view_array(Buffer_O_mat,n,p+1);
   gsl_matrix_view Buffer_F=gsl_matrix_view_array(Buffer_F_mat,n,p+1);
   gsl_vector_view CombA=gsl_vector_view_array(CombA_vec,n);
   gsl_vector_view CombB=gsl_vector_view_array(CombB_vec,n);
-  gsl_vector_view f_1=gsl_vector_view_array(f_1_vec,n);
-  gsl_vector_view PF_tmp=gsl_vector_view_array(puntoFisso_tmp,n);
-  gsl_vector_view A=gsl_vector_view_array(A_LMM,p+1);
-  gsl_vector_view B=gsl_vector_view_array(B_LMM,p+1);
+  gsl_vector_view A=gsl_vector_view_array(A_vec,p+1);
+  gsl_vector_view B=gsl_vector_view_array(B_vec,p+1);
+  struct SolutoreImplicito solutore;
+  SolutoreImplicitoInit(&solutore,infoSimulazione,n);
+  
+  //Gli eventi vengono cercati anche tra gli stati dell'innesco
+  struct RilevatoreEventi rilevatore;
+  gsl_vector_view innesco_0=gsl_matrix_column(innesco,0);
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(innesco_0.vector));
   
   size_t k=0;
   for(; k<p+1; ++k){
     gsl_vector_view col_k_O=gsl_matrix_column(innesco,k);
-    gsl_vector_view col_p_k_F=gsl_matrix_column(&(Buffer_F.matrix),p-k);
-    gsl_matrix_set_col(O_sim,k,&(col_k_O.vector));
+    gsl_vector_view col_k_F=gsl_matrix_column(&(Buffer_F.matrix),k);
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    gsl_vector_memcpy(&(O_k.vector),&(col_k_O.vector));
     
     double t_k=infoSimulazione->t0+((double)k)*infoSimulazione->h;
-    infoSimulazione->dinamica(t_k,&(col_k_O.vector),&(col_p_k_F.vector));
-    gsl_matrix_set_col(&(Buffer_O.matrix),p-k,&(col_k_O.vector));
+    ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k,&(col_k_O.vector),&(col_k_F.vector));
+    gsl_matrix_set_col(&(Buffer_O.matrix),k,&(col_k_O.vector));
+    EmettiStato(memoria,k,t_k);
+    if(k > 0){
+      gsl_vector_view col_k_1_O=gsl_matrix_column(innesco,k-1);
+      gsl_vector_view col_k_1_F=gsl_matrix_column(&(Buffer_F.matrix),k-1);
+      if(RilevaEventi(&rilevatore,t_k-infoSimulazione->h,&(col_k_1_O.vector),t_k,&(col_k_O.vector),&(col_k_1_F.vector),&(col_k_F.vector),NULL)) break;
+    }
   }
   double t_k=infoSimulazione->t0+((double)(k))*infoSimulazione->h,t_k_1=infoSimulazione->t0+((double)(k-1))*infoSimulazione->h;
-  for(;k < NumeroCampioni; ++k){
-    gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);
+  for(;k < NumeroCampioni && !rilevatore.terminato; ++k){
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
     //Se è verificata la condizione termino
     //printf("\nO_k_1\n");
     //gsl_vector_fprintf(stdout,&(O_k_1.vector),"%.10lf");
-    bool verificaCondizione = infoSimulazione->condizione == NULL ? 0 : infoSimulazione->condizione(t_k_1,&(O_k_1.vector));
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
     if(verificaCondizione) break;
     
-    gsl_vector_view O_k=gsl_matrix_column(O_sim,k);
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    //I coefficienti vengono ruotati sulle colonne, lo stato k-1-j e' nella colonna (k+p-j)%(p+1)
+    for(size_t j=0; j<=p; ++j){
+      size_t colonna=(k+p-j)%(p+1);
+      A_vec[colonna]=A_LMM[j];
+      B_vec[colonna]=B_LMM[j];
+    }
     gsl_blas_dgemv(CblasNoTrans,1.0,&(Buffer_O.matrix),&(A.vector),0.0,&(CombA.vector));
     gsl_blas_dgemv(CblasNoTrans,1.0,&(Buffer_F.matrix),&(B.vector),0.0,&(CombB.vector));
     gsl_vector_scale(&(CombB.vector),infoSimulazione->h);
@@ -307,58 +434,230 @@ gsl_matrix* LMM(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double
     //Se esplicito
     if(b_1 == 0.0){
       gsl_vector_add(&(CombA.vector),&(CombB.vector));
-      gsl_vector_add(&(O_k.vector),&(CombA.vector));
+      gsl_vector_memcpy(&(O_k.vector),&(CombA.vector));
     }else{ //Se implicito
-      //gsl_vector_view O_k_1=gsl_matrix_column(O_sim,k-1);
+      //gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
       gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
     
-      //Iterazioni di punto fisso
-      double epsilonPF=1e-15,errore=GSL_POSINF;
-      unsigned MAX_ITERS=50;
-      unsigned j=1;
-      while(errore >= epsilonPF && j <= MAX_ITERS){    
-        infoSimulazione->dinamica(t_k,&(O_k.vector),&(f_1.vector)); //Termine implicito
-        gsl_vector_scale(&(f_1.vector),b_1*infoSimulazione->h);
-        gsl_vector_add(&(f_1.vector),&(CombB.vector));
-        gsl_vector_add(&(f_1.vector),&(CombA.vector));
-        gsl_vector_memcpy(&(PF_tmp.vector),&(O_k.vector));
-        gsl_vector_memcpy(&(O_k.vector),&(f_1.vector));
-        
-        //Uso f_1 per il calcolo dell'errore
-        gsl_vector_sub(&(PF_tmp.vector),&(f_1.vector));
-        errore=gsl_blas_dnrm2(&(PF_tmp.vector));
-        ++j;
-      }
+      //Soluzione di O_k = CombA + h*CombB + b_1*h*f(t_k,O_k)
+      gsl_vector_add(&(CombA.vector),&(CombB.vector));
+      RisolviImplicito(&solutore,t_k,b_1*infoSimulazione->h,&(CombA.vector),&(O_k.vector));
     }
     
-    //swap buffers
-    for(unsigned j=0; j<p; ++j){
-      gsl_matrix_swap_columns(&(Buffer_O.matrix),p-j,p-j-1);
-      gsl_matrix_swap_columns(&(Buffer_F.matrix),p-j,p-j-1);
+    //Il nuovo stato prende il posto del piu' vecchio, nel caso implicito la dinamica si ricava dall'equazione risolta
+    //O_k = CombA + b_1*h*f(t_k,O_k) senza chiamare di nuovo la dinamica
+    gsl_vector_view f_k=gsl_matrix_column(&(Buffer_F.matrix),k%(p+1));
+    gsl_matrix_set_col(&(Buffer_O.matrix),k%(p+1),&(O_k.vector));
+    if(b_1 == 0.0){
+      ChiamaDinamica(infoSimulazione,infoSimulazione->statistiche,t_k,&(O_k.vector),&(f_k.vector));
+    }else{
+      gsl_vector_memcpy(&(f_k.vector),&(O_k.vector));
+      gsl_vector_sub(&(f_k.vector),&(CombA.vector));
+      gsl_vector_scale(&(f_k.vector),1.0/(b_1*infoSimulazione->h));
     }
-    infoSimulazione->dinamica(t_k,&(O_k.vector),&(f_1.vector));
-    gsl_matrix_set_col(&(Buffer_O.matrix),0,&(O_k.vector));
-    gsl_matrix_set_col(&(Buffer_F.matrix),0,&(f_1.vector));
     
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,infoSimulazione->h);
+    //Con p > 0 la dinamica nello stato precedente e' ancora nel buffer
+    gsl_vector_view f_k_1=gsl_matrix_column(&(Buffer_F.matrix),(k+p)%(p+1));
+    if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),p > 0 ? &(f_k_1.vector) : NULL,&(f_k.vector),NULL)) break;
     t_k_1=t_k;
     t_k = infoSimulazione->t0+((double)(k+1))*infoSimulazione->h;
   }
-  //Assegno gli istanti della condizione nel caso sia verificata
-  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=t_k_1;
-  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=k-1;
-  return O_sim;
+  SolutoreImplicitoLibera(&solutore);
+  free(Buffer_O_mat);
+  free(Buffer_F_mat);
+  free(CombA_vec);
+  free(CombB_vec);
+  RilevatoreEventiLibera(&rilevatore);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  const size_t ultimo= rilevatore.terminato ? k : k-1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=ultimo;
+  //Gli stati dell'innesco non sono passi del metodo
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,ultimo > p ? ultimo-p : 0);
+}
+
+//Sceglie il calcolo del metodo per il quale sono allocati i buffer
+static void PassoFissoCalcolo(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria,struct BufferPassoFisso* buffer){
+  switch(buffer->propagatore.metodo){
+    case PropagatoreEuleroAvanti: EuleroAvantiCalcolo(infoSimulazione,statoIniziale,memoria,buffer); break;
+    case PropagatoreEuleroIndietro: EuleroIndietroCalcolo(infoSimulazione,statoIniziale,memoria,buffer); break;
+    case PropagatoreCrankNicolson: CrankNicolsonCalcolo(infoSimulazione,statoIniziale,memoria,buffer); break;
+    case PropagatoreHeun: HeunCalcolo(infoSimulazione,statoIniziale,memoria,buffer); break;
+    case PropagatoreRungeKutta: RungeKuttaEsplicitoCalcolo(infoSimulazione,statoIniziale,memoria,buffer); break;
+    case PropagatoreRosenbrockW: RosenbrockWCalcolo(infoSimulazione,statoIniziale,memoria,buffer); break;
+  }
+}
+
+static gsl_matrix* PassoFisso(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,gsl_vector* statoIniziale){
+  struct MemoriaRisultato memoria;
+  struct BufferPassoFisso buffer;
+  MemoriaCompletaInit(&memoria,statoIniziale->size,CampioniSimulazione(infoSimulazione),infoSimulazione->disposizione);
+  BufferPassoFissoInit(&buffer,infoSimulazione,propagatore,statoIniziale->size);
+  PassoFissoCalcolo(infoSimulazione,statoIniziale,&memoria,&buffer);
+  BufferPassoFissoLibera(&buffer);
+  return memoria.O_sim;
+}
+
+static int PassoFissoFlusso(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  struct MemoriaRisultato memoria;
+  struct BufferPassoFisso buffer;
+  MemoriaFlussoInit(&memoria,statoIniziale->size,uscita,infoSimulazione);
+  BufferPassoFissoInit(&buffer,infoSimulazione,propagatore,statoIniziale->size);
+  PassoFissoCalcolo(infoSimulazione,statoIniziale,&memoria,&buffer);
+  BufferPassoFissoLibera(&buffer);
+  return MemoriaFlussoChiudi(&memoria);
+}
+
+gsl_matrix* EuleroAvanti(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+  const struct Propagatore propagatore={PropagatoreEuleroAvanti,NULL,NULL,0};
+  return PassoFisso(infoSimulazione,&propagatore,statoIniziale);
+}
+
+int EuleroAvantiFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  const struct Propagatore propagatore={PropagatoreEuleroAvanti,NULL,NULL,0};
+  return PassoFissoFlusso(infoSimulazione,&propagatore,statoIniziale,uscita);
+}
+
+gsl_matrix* EuleroIndietro(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+  const struct Propagatore propagatore={PropagatoreEuleroIndietro,NULL,NULL,0};
+  return PassoFisso(infoSimulazione,&propagatore,statoIniziale);
+}
+
+int EuleroIndietroFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  const struct Propagatore propagatore={PropagatoreEuleroIndietro,NULL,NULL,0};
+  return PassoFissoFlusso(infoSimulazione,&propagatore,statoIniziale,uscita);
+}
+
+gsl_matrix* CrankNicolson(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+  const struct Propagatore propagatore={PropagatoreCrankNicolson,NULL,NULL,0};
+  return PassoFisso(infoSimulazione,&propagatore,statoIniziale);
+}
+
+int CrankNicolsonFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  const struct Propagatore propagatore={PropagatoreCrankNicolson,NULL,NULL,0};
+  return PassoFissoFlusso(infoSimulazione,&propagatore,statoIniziale,uscita);
+}
+
+gsl_matrix* Heun(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+  const struct Propagatore propagatore={PropagatoreHeun,NULL,NULL,0};
+  return PassoFisso(infoSimulazione,&propagatore,statoIniziale);
+}
+
+int HeunFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  const struct Propagatore propagatore={PropagatoreHeun,NULL,NULL,0};
+  return PassoFissoFlusso(infoSimulazione,&propagatore,statoIniziale,uscita);
+}
+
+gsl_matrix* RungeKuttaEsplicito(struct InfoBaseSimulazione* infoSimulazione,double* A_Butcher, double* B_Butcher,const unsigned stadi,gsl_vector* statoIniziale){
+  const struct Propagatore propagatore={PropagatoreRungeKutta,A_Butcher,B_Butcher,stadi};
+  return PassoFisso(infoSimulazione,&propagatore,statoIniziale);
+}
+
+int RungeKuttaEsplicitoFlusso(struct InfoBaseSimulazione* infoSimulazione,double* A_Butcher, double* B_Butcher,const unsigned stadi,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  const struct Propagatore propagatore={PropagatoreRungeKutta,A_Butcher,B_Butcher,stadi};
+  return PassoFissoFlusso(infoSimulazione,&propagatore,statoIniziale,uscita);
+}
+
+gsl_matrix* RosenbrockW(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+  const struct Propagatore propagatore={PropagatoreRosenbrockW,NULL,NULL,0};
+  return PassoFisso(infoSimulazione,&propagatore,statoIniziale);
+}
+
+int RosenbrockWFlusso(struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  const struct Propagatore propagatore={PropagatoreRosenbrockW,NULL,NULL,0};
+  return PassoFissoFlusso(infoSimulazione,&propagatore,statoIniziale,uscita);
+}
+
+gsl_matrix* LMM(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco){
+  struct MemoriaRisultato memoria;
+  MemoriaCompletaInit(&memoria,innesco->size1,CampioniSimulazione(infoSimulazione),infoSimulazione->disposizione);
+  LMMCalcolo(infoSimulazione,A_LMM,B_LMM,b_1,innesco,&memoria);
+  return memoria.O_sim;
+}
+
+int LMMFlusso(struct InfoBaseSimulazione* infoSimulazione,double* A_LMM,double* B_LMM,double b_1,gsl_matrix* innesco,struct InfoUscita* uscita){
+  struct MemoriaRisultato memoria;
+  MemoriaFlussoInit(&memoria,innesco->size1,uscita,infoSimulazione);
+  LMMCalcolo(infoSimulazione,A_LMM,B_LMM,b_1,innesco,&memoria);
+  return MemoriaFlussoChiudi(&memoria);
+}
+
+void PropagaPassoFisso(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,gsl_vector* stato){
+  struct MemoriaRisultato memoria;
+  MemoriaFlussoInit(&memoria,stato->size,NULL,infoSimulazione);
+  size_t ultimo=0;
+  struct InfoBaseSimulazione infoPasso=*infoSimulazione;
+  infoPasso.condizione=NULL;
+  infoPasso.condizioneParametri=NULL;
+  infoPasso.tCondizione=NULL;
+  infoPasso.indiceCondizione=&ultimo;
+  infoPasso.eventi=NULL;
+  struct BufferPassoFisso buffer;
+  BufferPassoFissoInit(&buffer,&infoPasso,propagatore,stato->size);
+  PassoFissoCalcolo(&infoPasso,stato,&memoria,&buffer);
+  BufferPassoFissoLibera(&buffer);
+  gsl_vector_view finale=StatoMemoria(&memoria,ultimo);
+  gsl_vector_memcpy(stato,&(finale.vector));
+  MemoriaFlussoChiudi(&memoria);
+}
+
+/*! \brief Spazio di lavoro dei metodi a passo fisso: buffer del metodo e matrice dei risultati riusati tra i calcoli
+ */
+struct SpazioLavoro{
+  struct BufferPassoFisso buffer; /*!< Buffer del metodo e risolutore implicito*/
+  gsl_matrix* O_sim; /*!< Matrice dei risultati con la capacita' richiesta alla creazione*/
+  size_t campioni; /*!< Numero massimo di stati di un calcolo*/
+  enum Disposizione disposizione; /*!< Disposizione della matrice dei risultati*/
+  gsl_matrix_view risultato; /*!< Vista sugli stati dell'ultimo calcolo*/
+};
+
+struct SpazioLavoro* SpazioLavoroAlloca(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,size_t n){
+  struct SpazioLavoro* spazio=(struct SpazioLavoro*)malloc(sizeof(struct SpazioLavoro));
+  if(spazio == NULL) return NULL;
+  spazio->campioni=CampioniSimulazione(infoSimulazione);
+  spazio->disposizione=infoSimulazione->disposizione;
+  spazio->O_sim=AllocaRisultato(n,spazio->campioni,spazio->disposizione);
+  gsl_matrix_set_zero(spazio->O_sim);
+  BufferPassoFissoInit(&(spazio->buffer),infoSimulazione,propagatore,n);
+  return spazio;
+}
+
+void SpazioLavoroLibera(struct SpazioLavoro* spazio){
+  if(spazio == NULL) return;
+  BufferPassoFissoLibera(&(spazio->buffer));
+  gsl_matrix_free(spazio->O_sim);
+  free(spazio);
+}
+
+gsl_matrix* IntegraSpazioLavoro(struct SpazioLavoro* spazio,struct InfoBaseSimulazione* infoSimulazione,gsl_vector* statoIniziale){
+  const size_t campioni=CampioniSimulazione(infoSimulazione);
+  const size_t n=spazio->buffer.n;
+  if(statoIniziale->size != n || campioni > spazio->campioni || infoSimulazione->disposizione != spazio->disposizione) return NULL;
+  struct MemoriaRisultato memoria;
+  MemoriaEsternaInit(&memoria,spazio->O_sim,spazio->disposizione);
+  PassoFissoCalcolo(infoSimulazione,statoIniziale,&memoria,&(spazio->buffer));
+  spazio->risultato= spazio->disposizione == DisposizioneRighe ? gsl_matrix_submatrix(spazio->O_sim,0,0,campioni,n) : gsl_matrix_submatrix(spazio->O_sim,0,0,n,campioni);
+  return &(spazio->risultato.matrix);
 }
 
 int fwrite_matrix(FILE* file, gsl_matrix* matrice,double h, double T, double t0){
+  return fwrite_risultato(file,matrice,DisposizioneColonne,h,T,t0);
+}
+
+int fwrite_risultato(FILE* file, gsl_matrix* matrice,enum Disposizione disposizione,double h, double T, double t0){
+  //righe e colonne si riferiscono sempre a dimensione dello stato e numero di passi
   struct InfoMatrice infoSimulazione={
     .dimensioneStruct=sizeof(struct InfoMatrice),
-    .righe=matrice->size1,
-    .colonne=matrice->size2,
+    .righe= disposizione == DisposizioneRighe ? matrice->size2 : matrice->size1,
+    .colonne= disposizione == DisposizioneRighe ? matrice->size1 : matrice->size2,
     .h=h,
     .T=T,
-    .t0=t0
+    .t0=t0,
+    .disposizione=(size_t)disposizione
   };
-  if(fwrite(&infoSimulazione,sizeof(struct InfoMatrice),1,file) == 0) return 1;
+  if(ScriviIntestazione(file,&infoSimulazione) != 0) return 1;
   if(gsl_matrix_fwrite(file,matrice) != 0) return 1;
   return 0;
 }
@@ -0,0 +1,255 @@
+/*! \file ode_interno.h
+ *  \brief File header per le strutture e le funzioni interne della libreria
+ */
+#ifndef ODE_INTERNO_H
+#define ODE_INTERNO_H
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <gsl/gsl_permutation.h>
+#include <ode.h>
+
+/*! \brief Traccia per passo su stderr, compilata solo con ODE_TRACCIA definita
+ */
+#ifdef ODE_TRACCIA
+#define TRACCIA(...) fprintf(stderr,__VA_ARGS__)
+#else
+#define TRACCIA(...) ((void)0)
+#endif
+#define TRACCIA_PASSO(k,t,h) TRACCIA("ode: %s passo=%zu t=%.17g h=%.17g\n",__func__,(size_t)(k),(double)(t),(double)(h))
+
+/*! \brief Istante corrente in secondi per la misura dei tempi
+ */
+static inline double Orologio(void){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return (double)t.tv_sec+1e-9*(double)t.tv_nsec;
+}
+
+/*! \brief Chiama la dinamica, contando la chiamata e il suo tempo se le statistiche sono richieste
+ */
+static inline void ChiamaDinamica(const struct InfoBaseSimulazione* infoSimulazione,struct Statistiche* statistiche,double t,gsl_vector* y,gsl_vector* dy){
+  const double inizio= statistiche ? Orologio() : 0.0;
+  if(infoSimulazione->dinamicaParametri) infoSimulazione->dinamicaParametri(t,y,dy,infoSimulazione->parametri);
+  else infoSimulazione->dinamica(t,y,dy);
+  if(statistiche){
+    statistiche->tempoDinamica+=Orologio()-inizio;
+    ++(statistiche->chiamateDinamica);
+  }
+}
+
+/*! \brief Chiama la dinamica sugli stati per colonne allo stesso istante, in una sola chiamata se e' specificata dinamicaBlocco
+ */
+static inline void ChiamaDinamicaBlocco(const struct InfoBaseSimulazione* infoSimulazione,struct Statistiche* statistiche,double t,gsl_matrix* stati,gsl_matrix* derivate){
+  if(infoSimulazione->dinamicaBlocco == NULL){
+    for(size_t j=0; j<stati->size2; ++j){
+      gsl_vector_view x_j=gsl_matrix_column(stati,j);
+      gsl_vector_view f_j=gsl_matrix_column(derivate,j);
+      ChiamaDinamica(infoSimulazione,statistiche,t,&(x_j.vector),&(f_j.vector));
+    }
+    return;
+  }
+  const double inizio= statistiche ? Orologio() : 0.0;
+  infoSimulazione->dinamicaBlocco(t,stati,derivate,infoSimulazione->parametri);
+  if(statistiche){
+    statistiche->tempoDinamica+=Orologio()-inizio;
+    statistiche->chiamateDinamica+=stati->size2;
+  }
+}
+
+/*! \brief Valuta la condizione di uscita, falsa se non specificata
+ */
+static inline bool VerificaCondizione(const struct InfoBaseSimulazione* infoSimulazione,double t,gsl_vector* y){
+  if(infoSimulazione->condizioneParametri) return infoSimulazione->condizioneParametri(t,y,infoSimulazione->parametri);
+  return infoSimulazione->condizione ? infoSimulazione->condizione(t,y) : false;
+}
+
+/*! \brief Azzera le statistiche all'inizio di un calcolo, restituisce l'istante di inizio
+ */
+static inline double StatisticheInizio(struct Statistiche* statistiche){
+  if(statistiche == NULL) return 0.0;
+  memset(statistiche,0,sizeof(struct Statistiche));
+  return Orologio();
+}
+
+/*! \brief Completa le statistiche alla fine di un calcolo
+ */
+static inline void StatisticheFine(struct Statistiche* statistiche,double inizio,size_t passi){
+  if(statistiche == NULL) return;
+  statistiche->passi=passi;
+  statistiche->tempoTotale=Orologio()-inizio;
+}
+
+/*! \brief Alloca la matrice dei risultati secondo la disposizione richiesta
+ */
+static inline gsl_matrix* AllocaRisultato(size_t n,size_t campioni,enum Disposizione disposizione){
+  return disposizione == DisposizioneRighe ? gsl_matrix_alloc(campioni,n) : gsl_matrix_alloc(n,campioni);
+}
+
+/*! \brief Vista sullo stato k-esimo della matrice dei risultati, contigua in memoria con DisposizioneRighe
+ */
+static inline gsl_vector_view StatoRisultato(gsl_matrix* O_sim,size_t k,enum Disposizione disposizione){
+  return disposizione == DisposizioneRighe ? gsl_matrix_row(O_sim,k) : gsl_matrix_column(O_sim,k);
+}
+
+/*! \brief Numero di stati memorizzabili nella matrice dei risultati
+ */
+static inline size_t CampioniRisultato(const gsl_matrix* O_sim,enum Disposizione disposizione){
+  return disposizione == DisposizioneRighe ? O_sim->size1 : O_sim->size2;
+}
+
+/*! \brief Struttura dati per le informazioni sulla matrice del calcolo
+ *
+ *  Questa matrice viene scritta sempre all'inizio del file binario per specificare la disposizione del dati nel file
+ */
+struct InfoMatrice{
+  size_t dimensioneStruct; /*!< Dimensione di questa struttura*/
+  size_t righe; /*!< Numero di righe della matrice, ovvero la dimensione dello stato*/
+  size_t colonne; /*!< Numero di colonne della matrice, ovvero numero di passi del calcolo*/
+  double h; /*!< Passo di integrazione*/
+  double T; /*!< Periodo di integrazione*/
+  double t0; /*!< Istante iniziale del calcolo*/
+  size_t disposizione; /*!< Disposizione dei dati nel file, 0 se ogni riga è una componente dello stato, 1 se ogni riga è un istante*/
+};
+
+/*! \brief Memoria per i risultati del calcolo
+ *
+ *  Contiene l'intera traiettoria oppure, nei metodi in flusso, solo gli ultimi stati necessari al metodo; gli stati calcolati vengono passati all'uscita
+ */
+struct MemoriaRisultato{
+  gsl_matrix* O_sim; /*!< Matrice dei risultati o buffer circolare degli ultimi stati*/
+  enum Disposizione disposizione; /*!< Disposizione della matrice*/
+  size_t finestra; /*!< Numero di stati nel buffer circolare, 0 se la matrice contiene tutta la traiettoria*/
+  struct InfoUscita* uscita; /*!< Uscita degli stati calcolati, nullptr se non specificata*/
+  size_t prossimoIstante; /*!< Indice del prossimo istante richiesto dall'uscita*/
+  long posizioneIntestazione; /*!< Posizione dell'intestazione nel file di uscita, -1 se il file non permette di riscriverla*/
+  struct InfoMatrice intestazione; /*!< Intestazione scritta nel file di uscita*/
+  int errore; /*!< Diverso da 0 se la scrittura su file non è riuscita*/
+};
+
+/*! \brief Vista sullo stato k-esimo della memoria dei risultati
+ */
+static inline gsl_vector_view StatoMemoria(struct MemoriaRisultato* memoria,size_t k){
+  return StatoRisultato(memoria->O_sim, memoria->finestra ? k%(memoria->finestra) : k, memoria->disposizione);
+}
+
+/*! \brief Numero di campioni della griglia a passo fisso
+ */
+static inline size_t CampioniSimulazione(const struct InfoBaseSimulazione* infoSimulazione){
+  return (size_t)floor(infoSimulazione->T/infoSimulazione->h)+1;
+}
+
+void MemoriaCompletaInit(struct MemoriaRisultato* memoria,size_t n,size_t campioni,enum Disposizione disposizione);
+void MemoriaEsternaInit(struct MemoriaRisultato* memoria,gsl_matrix* O_sim,enum Disposizione disposizione);
+void MemoriaFlussoInit(struct MemoriaRisultato* memoria,size_t n,struct InfoUscita* uscita,const struct InfoBaseSimulazione* infoSimulazione);
+int MemoriaFlussoChiudi(struct MemoriaRisultato* memoria);
+void EmettiStato(struct MemoriaRisultato* memoria,size_t k,double t);
+int ScriviIntestazione(FILE* file,const struct InfoMatrice* intestazione);
+
+double NormaErrore(const gsl_vector* errore,const gsl_vector* y0,const gsl_vector* y1,double tollAss,double tollRel);
+gsl_matrix* RidimensionaRisultato(gsl_matrix* O_sim,size_t usati,size_t capacita,enum Disposizione disposizione);
+gsl_vector* EspandiIstanti(gsl_vector* istanti,size_t usati);
+double StimaPassoIniziale(struct InfoBaseSimulazione* infoSimulazione,const gsl_vector* statoIniziale,const gsl_vector* f0,unsigned ordine,double tollAss,double tollRel,double hMax,gsl_vector* y,gsl_vector* f);
+
+/*! \brief Porta stato da t0 a t0+T con un metodo a passo fisso conservando solo gli ultimi stati, senza condizione ed eventi
+ */
+void PropagaPassoFisso(struct InfoBaseSimulazione* infoSimulazione,const struct Propagatore* propagatore,gsl_vector* stato);
+
+/*! \brief Esegue i compiti 0..numeroCompiti-1 distribuendoli su numeroThread thread, il thread chiamante compreso
+ */
+void EseguiInParallelo(unsigned numeroThread,size_t numeroCompiti,void (*compito)(size_t,void*),void* dati);
+
+/*! \brief Stato del risolutore delle equazioni implicite y = r + gamma*f(t,y)
+ *
+ *  Lo jacobiano e la sua fattorizzazione LU vengono mantenuti tra una chiamata e l'altra e ricalcolati solo quando la convergenza rallenta
+ */
+struct SolutoreImplicito{
+  struct InfoImplicito info; /*!< Impostazioni con i valori predefiniti gia' applicati*/
+  const struct InfoBaseSimulazione* infoSimulazione; /*!< Impostazioni del calcolo, per la dinamica e i dati dell'utente*/
+  struct Statistiche* statistiche; /*!< Statistiche del calcolo, nullptr se non richieste*/
+  size_t n; /*!< Dimensione dello stato*/
+  gsl_matrix* J; /*!< Jacobiano della dinamica. Con JacobianoBanda una riga per equazione con J(i,j) nella colonna j-i+bandaInferiore*/
+  gsl_matrix* LU; /*!< Fattorizzazione LU della matrice di iterazione I-gamma*J. A banda con bandaInferiore diagonali in piu' per gli scambi di righe*/
+  gsl_permutation* permutazione; /*!< Permutazione della fattorizzazione LU densa*/
+  size_t* pivot; /*!< Con JacobianoBanda, riga scambiata con ogni riga durante la fattorizzazione*/
+  double* valori; /*!< Con JacobianoSparso, valori dello jacobiano nell'ordine di info.colonne*/
+  double* fattori; /*!< Con JacobianoSparso, fattori L e U fuori dalla diagonale della fattorizzazione incompleta ILU(0) della matrice di iterazione*/
+  double* diagonale; /*!< Con JacobianoSparso, diagonale di U della fattorizzazione incompleta*/
+  size_t* posizioniRiga; /*!< Con JacobianoSparso, buffer con la posizione in valori di ogni colonna della riga in fattorizzazione*/
+  size_t* inizioColonne; /*!< Con JacobianoSparso, n+1 posizioni di inizio delle colonne in posizioniColonne*/
+  size_t* posizioniColonne; /*!< Con JacobianoSparso, posizioni in valori dei non nulli ordinati per colonna*/
+  size_t* righeColonne; /*!< Con JacobianoSparso, righe dei non nulli ordinati per colonna*/
+  size_t* colonneColore; /*!< Colonne raggruppate per colore, due colonne dello stesso colore non hanno righe in comune*/
+  size_t* inizioColori; /*!< numeroColori+1 posizioni di inizio dei colori in colonneColore*/
+  size_t numeroColori; /*!< Numero di valutazioni della dinamica per jacobiano alle differenze finite*/
+  gsl_vector* perturbato; /*!< Buffer per lo stato perturbato delle differenze finite*/
+  gsl_matrix* statiColori; /*!< Con la dinamica a blocchi, stati perturbati per ogni colore per colonne*/
+  gsl_matrix* derivateColori; /*!< Con la dinamica a blocchi, dinamica negli stati perturbati per colonne*/
+  gsl_matrix* V; /*!< Base di Krylov di GMRES per righe*/
+  gsl_matrix* H; /*!< Matrice di Hessenberg di GMRES, triangolarizzata con le rotazioni di Givens*/
+  gsl_vector* rotazioni; /*!< Coseni e seni delle rotazioni di Givens, alternati*/
+  gsl_vector* g; /*!< Residuo ruotato di GMRES*/
+  gsl_vector* w; /*!< Buffer per il prodotto della matrice di iterazione*/
+  gsl_vector* b; /*!< Copia del termine noto di GMRES*/
+  gsl_vector* fPerturbato; /*!< Con JacobianoLibero, buffer per la dinamica nello stato perturbato*/
+  const gsl_vector* y; /*!< Stato dell'iterazione corrente, per il prodotto jacobiano-vettore di JacobianoLibero*/
+  double t; /*!< Istante dell'iterazione corrente*/
+  gsl_vector* f; /*!< Buffer per la dinamica*/
+  gsl_vector* delta; /*!< Buffer per la correzione dell'iterazione*/
+  gsl_vector* iniziale; /*!< Copia della stima iniziale per ripetere le iterazioni*/
+  bool jacobianoValido; /*!< Indica se J e' disponibile*/
+  double gammaFattorizzato; /*!< Valore di gamma con cui e' stata calcolata la fattorizzazione, NaN se non disponibile*/
+  double variazioneGamma; /*!< Variazione relativa di gamma entro la quale la fattorizzazione viene riusata, 0 per rifattorizzare a ogni cambio*/
+  double contrazione; /*!< Rapporto tra le ultime due correzioni dell'ultima equazione risolta, 0 se c'e' stata una sola iterazione. Con il punto fisso stima gamma*rho*/
+  double tolleranzaAssoluta; /*!< Tolleranza assoluta della norma pesata di NormaErrore usata per la convergenza, con la relativa entrambe nulle per la norma 2 della correzione*/
+  double tolleranzaRelativa; /*!< Tolleranza relativa della norma pesata usata per la convergenza*/
+};
+
+void SolutoreImplicitoInit(struct SolutoreImplicito* solutore,struct InfoBaseSimulazione* infoSimulazione,size_t n);
+void SolutoreImplicitoLibera(struct SolutoreImplicito* solutore);
+void SolutoreImplicitoRiavvia(struct SolutoreImplicito* solutore,struct InfoBaseSimulazione* infoSimulazione);
+bool RisolviImplicito(struct SolutoreImplicito* solutore,double t,double gamma,const gsl_vector* r,gsl_vector* y);
+
+/*! \brief Inizializza il risolutore per i metodi linearmente impliciti, con i buffer di Newton anche se infoSimulazione chiede il punto fisso
+ */
+void SolutoreLinearizzatoInit(struct SolutoreImplicito* solutore,struct InfoBaseSimulazione* infoSimulazione,size_t n);
+
+/*! \brief Calcola f(t,y) in solutore->f, lo jacobiano in (t,y) e la fattorizzazione di I-gamma*J. y deve restare valido fino all'ultima soluzione con JacobianoLibero
+ */
+void LinearizzaImplicito(struct SolutoreImplicito* solutore,double t,gsl_vector* y,double gamma);
+
+/*! \brief Soluzione in place di (I-gamma*J)*x = x con la fattorizzazione di LinearizzaImplicito, senza iterazioni di Newton
+ */
+void RisolviLinearizzato(struct SolutoreImplicito* solutore,double gamma,gsl_vector* x);
+
+/*! \brief Norma infinito dello jacobiano memorizzato, che maggiora il raggio spettrale. NaN se lo jacobiano non e' disponibile o con JacobianoLibero
+ */
+double NormaJacobiano(const struct SolutoreImplicito* solutore);
+
+/*! \brief Stato della ricerca degli eventi durante un calcolo
+ *
+ *  Se infoSimulazione non specifica eventi info e' nullptr e RilevaEventi non fa nulla
+ */
+struct RilevatoreEventi{
+  struct InfoEventi* info; /*!< Eventi da cercare, nullptr se non specificati*/
+  const struct InfoBaseSimulazione* infoSimulazione; /*!< Impostazioni del calcolo, per la dinamica dell'interpolante di Hermite e i dati dell'utente*/
+  struct Statistiche* statistiche; /*!< Statistiche del calcolo, nullptr se non richieste*/
+  size_t n; /*!< Dimensione dello stato*/
+  double* g; /*!< Valore delle funzioni degli eventi all'inizio del passo*/
+  double* g1; /*!< Valore delle funzioni degli eventi alla fine del passo, scambiato con g quando il passo viene superato*/
+  double* theta; /*!< Istanti normalizzati degli eventi trovati nel passo*/
+  size_t* trovati; /*!< Indici degli eventi trovati nel passo*/
+  gsl_vector* f0; /*!< Buffer per la dinamica all'inizio del passo*/
+  gsl_vector* f1; /*!< Buffer per la dinamica alla fine del passo*/
+  gsl_vector* y; /*!< Buffer per lo stato interpolato*/
+  bool terminato; /*!< Vero se e' stato trovato un evento terminale*/
+  double tTerminale; /*!< Istante dell'evento terminale*/
+};
+
+void RilevatoreEventiInit(struct RilevatoreEventi* rilevatore,struct InfoBaseSimulazione* infoSimulazione,size_t n,double t0,gsl_vector* y0);
+void RilevatoreEventiLibera(struct RilevatoreEventi* rilevatore);
+bool RilevaEventi(struct RilevatoreEventi* rilevatore,double t0,gsl_vector* y0,double t1,gsl_vector* y1,const gsl_vector* f0,const gsl_vector* f1,const gsl_vector* correzione);
+void InterpolaHermite(double theta,double h,const gsl_vector* y0,const gsl_vector* y1,const gsl_vector* f0,const gsl_vector* f1,const gsl_vector* correzione,gsl_vector* y);
+
+#endif
@@ -0,0 +1,50 @@
+#include <pthread.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//Stato condiviso tra i thread, i compiti vengono assegnati dinamicamente con un contatore protetto
+struct CodaCompiti{
+  pthread_mutex_t mutex;
+  size_t prossimo;
+  size_t numeroCompiti;
+  void (*compito)(size_t,void*);
+  void* dati;
+};
+
+static void* EsecutoreCompiti(void* argomento){
+  struct CodaCompiti* coda=(struct CodaCompiti*)argomento;
+  while(true){
+    pthread_mutex_lock(&(coda->mutex));
+    size_t indice=coda->prossimo++;
+    pthread_mutex_unlock(&(coda->mutex));
+    if(indice >= coda->numeroCompiti) break;
+    coda->compito(indice,coda->dati);
+  }
+  return NULL;
+}
+
+void EseguiInParallelo(unsigned numeroThread,size_t numeroCompiti,void (*compito)(size_t,void*),void* dati){
+  if(numeroThread > numeroCompiti) numeroThread=(unsigned)numeroCompiti;
+  //Senza thread aggiuntivi i compiti vengono eseguiti nel thread chiamante
+  if(numeroThread <= 1){
+    for(size_t i=0; i<numeroCompiti; ++i) compito(i,dati);
+    return;
+  }
+  
+  struct CodaCompiti coda;
+  pthread_mutex_init(&(coda.mutex),NULL);
+  coda.prossimo=0;
+  coda.numeroCompiti=numeroCompiti;
+  coda.compito=compito;
+  coda.dati=dati;
+  
+  //Il thread chiamante partecipa all'esecuzione
+  pthread_t thread[numeroThread-1];
+  unsigned avviati=0;
+  for(; avviati<numeroThread-1; ++avviati){
+    if(pthread_create(&(thread[avviati]),NULL,EsecutoreCompiti,&coda) != 0) break;
+  }
+  EsecutoreCompiti(&coda);
+  for(unsigned i=0; i<avviati; ++i) pthread_join(thread[i],NULL);
+  pthread_mutex_destroy(&(coda.mutex));
+}
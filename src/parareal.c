@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <math.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+//Dati condivisi dai compiti del propagatore fine
+struct CalcoloParareal{
+  struct InfoBaseSimulazione* infoSimulazione;
+  struct InfoParareal* infoParareal;
+  gsl_matrix* O_sim; //Stati ai bordi degli intervalli
+  gsl_matrix* F; //Risultato del propagatore fine su ogni intervallo, per righe
+  double dT; //Durata di un intervallo
+  size_t primoIntervallo; //Primo intervallo non ancora esatto
+  struct Statistiche* statisticheIntervalli; //Statistiche di ogni intervallo, sommate dopo ogni esecuzione. nullptr se non richieste
+};
+
+//Somma le statistiche di una esecuzione di un propagatore a quelle del calcolo
+static void SommaStatistiche(struct Statistiche* totale,const struct Statistiche* parziale){
+  totale->passi+=parziale->passi;
+  totale->passiRifiutati+=parziale->passiRifiutati;
+  totale->chiamateDinamica+=parziale->chiamateDinamica;
+  totale->iterazioni+=parziale->iterazioni;
+  totale->passiNonConvergenti+=parziale->passiNonConvergenti;
+  totale->jacobiani+=parziale->jacobiani;
+  totale->fattorizzazioni+=parziale->fattorizzazioni;
+  totale->iterazioniLineari+=parziale->iterazioniLineari;
+  totale->tempoDinamica+=parziale->tempoDinamica;
+}
+
+//Propaga stato sull'intervallo j con il passo piu' vicino a h che divide esattamente l'intervallo
+static void PropagaIntervallo(struct CalcoloParareal* calcolo,const struct Propagatore* propagatore,double h,size_t j,gsl_vector* stato,struct Statistiche* statistiche){
+  const double passi=GSL_MAX(1.0,ceil(calcolo->dT/h-1e-9));
+  struct InfoBaseSimulazione infoIntervallo=*(calcolo->infoSimulazione);
+  infoIntervallo.t0=calcolo->infoSimulazione->t0+((double)j)*calcolo->dT;
+  infoIntervallo.h=calcolo->dT/passi;
+  //Mezzo passo in piu' perche' floor(T/h) dia il numero di passi indipendentemente dall'arrotondamento
+  infoIntervallo.T=(passi+0.5)*infoIntervallo.h;
+  infoIntervallo.statistiche=statistiche;
+  PropagaPassoFisso(&infoIntervallo,propagatore,stato);
+}
+
+static void PropagatoreFine(size_t compito,void* dati){
+  struct CalcoloParareal* calcolo=(struct CalcoloParareal*)dati;
+  const size_t j=calcolo->primoIntervallo+compito;
+  gsl_vector_view x_j=StatoRisultato(calcolo->O_sim,j,calcolo->infoSimulazione->disposizione);
+  gsl_vector_view F_j=gsl_matrix_row(calcolo->F,j);
+  gsl_vector_memcpy(&(F_j.vector),&(x_j.vector));
+  struct Statistiche* statistiche= calcolo->statisticheIntervalli ? calcolo->statisticheIntervalli+j : NULL;
+  PropagaIntervallo(calcolo,&(calcolo->infoParareal->fine),calcolo->infoSimulazione->h,j,&(F_j.vector),statistiche);
+}
+
+gsl_matrix* Parareal(struct InfoBaseSimulazione* infoSimulazione,struct InfoParareal* infoParareal,gsl_vector* statoIniziale){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t n=statoIniziale->size;
+  const enum Disposizione disposizione=infoSimulazione->disposizione;
+  const size_t N= infoParareal->intervalli ? infoParareal->intervalli : GSL_MAX(infoParareal->numeroThread,1u);
+  const double tolleranza= infoParareal->tolleranza > 0.0 ? infoParareal->tolleranza : 1e-10;
+  const size_t maxIterazioni= (infoParareal->maxIterazioni > 0 && infoParareal->maxIterazioni < N) ? infoParareal->maxIterazioni : N;
+  struct Statistiche* statistiche=infoSimulazione->statistiche;
+  struct Statistiche statisticheGrossolano;
+
+  struct CalcoloParareal calcolo={
+    .infoSimulazione=infoSimulazione,
+    .infoParareal=infoParareal,
+    .O_sim=AllocaRisultato(n,N+1,disposizione),
+    .F=gsl_matrix_alloc(N,n),
+    .dT=infoSimulazione->T/(double)N,
+    .primoIntervallo=0,
+    .statisticheIntervalli= statistiche ? (struct Statistiche*)calloc(N,sizeof(struct Statistiche)) : NULL
+  };
+  const double hGrossolano= infoParareal->hGrossolano > 0.0 ? infoParareal->hGrossolano : calcolo.dT;
+  //G contiene il risultato del propagatore grossolano su ogni intervallo dall'ultima iterazione, per righe
+  gsl_matrix* G=gsl_matrix_alloc(N,n);
+  gsl_vector* x=gsl_vector_alloc(n);
+
+  //Iterazione 0: solo il propagatore grossolano, in serie
+  gsl_vector_view x_0=StatoRisultato(calcolo.O_sim,0,disposizione);
+  gsl_vector_memcpy(&(x_0.vector),statoIniziale);
+  for(size_t j=0; j<N; ++j){
+    gsl_vector_view x_j=StatoRisultato(calcolo.O_sim,j,disposizione);
+    gsl_vector_view x_j1=StatoRisultato(calcolo.O_sim,j+1,disposizione);
+    gsl_vector_view G_j=gsl_matrix_row(G,j);
+    gsl_vector_memcpy(&(G_j.vector),&(x_j.vector));
+    PropagaIntervallo(&calcolo,&(infoParareal->grossolano),hGrossolano,j,&(G_j.vector),statistiche ? &statisticheGrossolano : NULL);
+    if(statistiche) SommaStatistiche(statistiche,&statisticheGrossolano);
+    gsl_vector_memcpy(&(x_j1.vector),&(G_j.vector));
+  }
+
+  unsigned iterazione=0;
+  double correzione=GSL_POSINF;
+  while(iterazione < maxIterazioni){
+    //Propagatore fine in parallelo sugli intervalli che non sono ancora esatti
+    calcolo.primoIntervallo=iterazione;
+    EseguiInParallelo(infoParareal->numeroThread,N-calcolo.primoIntervallo,PropagatoreFine,&calcolo);
+    if(statistiche){
+      for(size_t j=calcolo.primoIntervallo; j<N; ++j) SommaStatistiche(statistiche,calcolo.statisticheIntervalli+j);
+    }
+
+    //Correzione in serie: x_{j+1} = G(x_j) + F_j - G_j
+    correzione=0.0;
+    for(size_t j=calcolo.primoIntervallo; j<N; ++j){
+      gsl_vector_view x_j=StatoRisultato(calcolo.O_sim,j,disposizione);
+      gsl_vector_view x_j1=StatoRisultato(calcolo.O_sim,j+1,disposizione);
+      gsl_vector_view G_j=gsl_matrix_row(G,j);
+      gsl_vector_view F_j=gsl_matrix_row(calcolo.F,j);
+      //Sul primo intervallo lo stato iniziale non e' cambiato, quindi G(x_j) e' gia' in G_j
+      gsl_vector_memcpy(x,&(x_j.vector));
+      if(j > calcolo.primoIntervallo){
+        PropagaIntervallo(&calcolo,&(infoParareal->grossolano),hGrossolano,j,x,statistiche ? &statisticheGrossolano : NULL);
+        if(statistiche) SommaStatistiche(statistiche,&statisticheGrossolano);
+      }else{
+        gsl_vector_memcpy(x,&(G_j.vector));
+      }
+      for(size_t i=0; i<n; ++i){
+        double nuovo=gsl_vector_get(x,i)+gsl_vector_get(&(F_j.vector),i)-gsl_vector_get(&(G_j.vector),i);
+        correzione=GSL_MAX(correzione,fabs(nuovo-gsl_vector_get(&(x_j1.vector),i))/(1.0+fabs(nuovo)));
+        gsl_vector_set(&(x_j1.vector),i,nuovo);
+      }
+      gsl_vector_memcpy(&(G_j.vector),x);
+    }
+    ++iterazione;
+    TRACCIA("ode: %s iterazione=%u correzione=%g\n",__func__,iterazione,correzione);
+    if(correzione <= tolleranza) break;
+  }
+
+  infoParareal->iterazioni=iterazione;
+  infoParareal->correzione=correzione;
+  gsl_matrix_free(calcolo.F);
+  gsl_matrix_free(G);
+  gsl_vector_free(x);
+  free(calcolo.statisticheIntervalli);
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)=infoSimulazione->t0+infoSimulazione->T;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)=N;
+  //I passi sono quelli di tutte le esecuzioni dei propagatori
+  if(statistiche) StatisticheFine(statistiche,inizioCalcolo,statistiche->passi);
+  return calcolo.O_sim;
+}
@@ -0,0 +1,191 @@
+#include <math.h>
+#include <stdlib.h>
+#include <gsl/gsl_blas.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+#define StadiMassimiComposizione 8
+
+//Pesi delle composizioni simmetriche di Stormer-Verlet di Yoshida, Stormer-Verlet e' la composizione di un solo passo
+static const double PesiVerlet[1]={1.0};
+static const double PesiYoshida4[3]={
+  1.351207191959657634,
+  -1.702414383919315268,
+  1.351207191959657634
+};
+static const double PesiYoshida6[7]={
+  0.784513610477560,
+  0.235573213359357,
+  -1.17767998417887,
+  1.31518632068391,
+  -1.17767998417887,
+  0.235573213359357,
+  0.784513610477560
+};
+
+//Coefficienti kick-drift della composizione dei passi di Stormer-Verlet con i pesi w: i mezzi kick adiacenti vengono uniti,
+//l'ultimo drift e' nullo quindi la forza finale serve al primo kick del passo successivo
+static unsigned CoefficientiComposizione(const double* w,unsigned passi,double* a,double* b){
+  b[0]=0.5*w[0];
+  for(unsigned i=0; i<passi; ++i){
+    a[i]=w[i];
+    b[i+1]= i+1 < passi ? 0.5*(w[i]+w[i+1]) : 0.5*w[i];
+  }
+  a[passi]=0.0;
+  return passi+1;
+}
+
+/*! \brief Buffer e coefficienti di un calcolo simplettico
+ */
+struct CalcoloSimplettico{
+  const struct InfoBaseSimulazione* infoSimulazione; /*!< Impostazioni del calcolo, per i dati dell'utente e le statistiche*/
+  const struct InfoSimplettico* infoSimplettico; /*!< Forza e velocita'*/
+  const double* a; /*!< Coefficienti dei drift*/
+  const double* b; /*!< Coefficienti dei kick*/
+  unsigned stadi; /*!< Numero di stadi*/
+  double A[StadiMassimiComposizione]; /*!< Coefficienti dei drift delle composizioni*/
+  double B[StadiMassimiComposizione]; /*!< Coefficienti dei kick delle composizioni*/
+  gsl_vector* F; /*!< Forza nelle posizioni correnti*/
+  gsl_vector* v; /*!< Velocita' nei momenti correnti*/
+  bool forzaValida; /*!< Vero se F corrisponde alle posizioni correnti*/
+};
+
+static void ChiamaForza(struct CalcoloSimplettico* calcolo,double t,gsl_vector* q){
+  struct Statistiche* statistiche=calcolo->infoSimulazione->statistiche;
+  const double inizio= statistiche ? Orologio() : 0.0;
+  calcolo->infoSimplettico->forza(t,q,calcolo->F,calcolo->infoSimulazione->parametri);
+  if(statistiche){
+    statistiche->tempoDinamica+=Orologio()-inizio;
+    ++(statistiche->chiamateDinamica);
+  }
+  calcolo->forzaValida=true;
+}
+
+//Velocita' in v, con la velocita' predefinita v=p senza copie
+static gsl_vector* ChiamaVelocita(struct CalcoloSimplettico* calcolo,double t,gsl_vector* p){
+  if(calcolo->infoSimplettico->velocita == NULL) return p;
+  struct Statistiche* statistiche=calcolo->infoSimulazione->statistiche;
+  const double inizio= statistiche ? Orologio() : 0.0;
+  calcolo->infoSimplettico->velocita(t,p,calcolo->v,calcolo->infoSimulazione->parametri);
+  if(statistiche) statistiche->tempoDinamica+=Orologio()-inizio;
+  return calcolo->v;
+}
+
+//Dinamica completa [v(p), F(q)] per l'interpolante degli eventi, riusa la forza se gia' calcolata
+static void DinamicaSimplettica(struct CalcoloSimplettico* calcolo,double t,gsl_vector* x,gsl_vector* f){
+  const size_t m=x->size/2;
+  gsl_vector_view q=gsl_vector_subvector(x,0,m);
+  gsl_vector_view p=gsl_vector_subvector(x,m,m);
+  gsl_vector_view dq=gsl_vector_subvector(f,0,m);
+  gsl_vector_view dp=gsl_vector_subvector(f,m,m);
+  if(!calcolo->forzaValida) ChiamaForza(calcolo,t,&(q.vector));
+  gsl_vector_memcpy(&(dp.vector),calcolo->F);
+  gsl_vector_memcpy(&(dq.vector),ChiamaVelocita(calcolo,t,&(p.vector)));
+}
+
+static void SimpletticoCalcolo(struct InfoBaseSimulazione* infoSimulazione,struct InfoSimplettico* infoSimplettico,gsl_vector* statoIniziale,struct MemoriaRisultato* memoria){
+  const double inizioCalcolo=StatisticheInizio(infoSimulazione->statistiche);
+  const size_t NumeroCampioni=CampioniSimulazione(infoSimulazione);
+  const size_t n=statoIniziale->size;
+  const size_t m=n/2;
+  const double h=infoSimulazione->h;
+
+  struct CalcoloSimplettico calcolo;
+  calcolo.infoSimulazione=infoSimulazione;
+  calcolo.infoSimplettico=infoSimplettico;
+  switch(infoSimplettico->metodo){
+    case StormerVerlet:
+      calcolo.stadi=CoefficientiComposizione(PesiVerlet,1,calcolo.A,calcolo.B);
+      break;
+    case Yoshida4:
+      calcolo.stadi=CoefficientiComposizione(PesiYoshida4,3,calcolo.A,calcolo.B);
+      break;
+    case Yoshida6:
+      calcolo.stadi=CoefficientiComposizione(PesiYoshida6,7,calcolo.A,calcolo.B);
+      break;
+    case SimpletticoPartizionato:
+      calcolo.stadi=infoSimplettico->stadi;
+      break;
+  }
+  calcolo.a= infoSimplettico->metodo == SimpletticoPartizionato ? infoSimplettico->a : calcolo.A;
+  calcolo.b= infoSimplettico->metodo == SimpletticoPartizionato ? infoSimplettico->b : calcolo.B;
+  calcolo.F=gsl_vector_alloc(m);
+  calcolo.v= infoSimplettico->velocita ? gsl_vector_alloc(m) : NULL;
+  calcolo.forzaValida=false;
+
+  //Inserimento stato iniziale
+  gsl_vector_view O_0=StatoMemoria(memoria,0);
+  gsl_vector_memcpy(&(O_0.vector),statoIniziale);
+  EmettiStato(memoria,0,infoSimulazione->t0);
+  struct RilevatoreEventi rilevatore;
+  RilevatoreEventiInit(&rilevatore,infoSimulazione,n,infoSimulazione->t0,&(O_0.vector));
+  //La dinamica agli estremi del passo serve solo agli eventi, quella finale diventa l'iniziale del passo successivo
+  gsl_vector* f_k_1=NULL,*f_k=NULL;
+  if(rilevatore.info){
+    f_k_1=gsl_vector_alloc(n);
+    f_k=gsl_vector_alloc(n);
+    DinamicaSimplettica(&calcolo,infoSimulazione->t0,&(O_0.vector),f_k_1);
+  }
+
+  double t_k=infoSimulazione->t0+h,t_k_1=infoSimulazione->t0;
+  size_t k=1;
+  for(;k < NumeroCampioni; ++k){
+    gsl_vector_view O_k_1=StatoMemoria(memoria,k-1);
+    //Se è verificata la condizione termino
+    bool verificaCondizione = VerificaCondizione(infoSimulazione,t_k_1,&(O_k_1.vector));
+    if(verificaCondizione) break;
+
+    gsl_vector_view O_k=StatoMemoria(memoria,k);
+    gsl_vector_memcpy(&(O_k.vector), &(O_k_1.vector));
+    gsl_vector_view q=gsl_vector_subvector(&(O_k.vector),0,m);
+    gsl_vector_view p=gsl_vector_subvector(&(O_k.vector),m,m);
+
+    //Kick e drift alternati, l'istante avanza con i drift
+    double t=t_k_1;
+    for(unsigned i=0; i<calcolo.stadi; ++i){
+      if(calcolo.b[i] != 0.0){
+        if(!calcolo.forzaValida) ChiamaForza(&calcolo,t,&(q.vector));
+        gsl_blas_daxpy(calcolo.b[i]*h,calcolo.F,&(p.vector));
+      }
+      if(calcolo.a[i] != 0.0){
+        gsl_blas_daxpy(calcolo.a[i]*h,ChiamaVelocita(&calcolo,t,&(p.vector)),&(q.vector));
+        calcolo.forzaValida=false;
+        t+=calcolo.a[i]*h;
+      }
+    }
+    EmettiStato(memoria,k,t_k);
+    TRACCIA_PASSO(k,t_k,h);
+    if(rilevatore.info){
+      DinamicaSimplettica(&calcolo,t_k,&(O_k.vector),f_k);
+      if(RilevaEventi(&rilevatore,t_k_1,&(O_k_1.vector),t_k,&(O_k.vector),f_k_1,f_k,NULL)) break;
+      gsl_vector* scambio=f_k_1;
+      f_k_1=f_k;
+      f_k=scambio;
+    }
+    t_k_1=t_k;
+    t_k = infoSimulazione->t0+((double)(k+1))*h;
+  }
+  RilevatoreEventiLibera(&rilevatore);
+  gsl_vector_free(calcolo.F);
+  if(calcolo.v) gsl_vector_free(calcolo.v);
+  if(f_k_1) gsl_vector_free(f_k_1);
+  if(f_k) gsl_vector_free(f_k);
+  //Assegno gli istanti della condizione o dell'evento terminale nel caso siano verificati
+  if(infoSimulazione->tCondizione) *(infoSimulazione->tCondizione)= rilevatore.terminato ? rilevatore.tTerminale : t_k_1;
+  if(infoSimulazione->indiceCondizione) *(infoSimulazione->indiceCondizione)= rilevatore.terminato ? k : k-1;
+  StatisticheFine(infoSimulazione->statistiche,inizioCalcolo,rilevatore.terminato ? k : k-1);
+}
+
+gsl_matrix* Simplettico(struct InfoBaseSimulazione* infoSimulazione,struct InfoSimplettico* infoSimplettico,gsl_vector* statoIniziale){
+  struct MemoriaRisultato memoria;
+  MemoriaCompletaInit(&memoria,statoIniziale->size,CampioniSimulazione(infoSimulazione),infoSimulazione->disposizione);
+  SimpletticoCalcolo(infoSimulazione,infoSimplettico,statoIniziale,&memoria);
+  return memoria.O_sim;
+}
+
+int SimpletticoFlusso(struct InfoBaseSimulazione* infoSimulazione,struct InfoSimplettico* infoSimplettico,gsl_vector* statoIniziale,struct InfoUscita* uscita){
+  struct MemoriaRisultato memoria;
+  MemoriaFlussoInit(&memoria,statoIniziale->size,uscita,infoSimulazione);
+  SimpletticoCalcolo(infoSimulazione,infoSimplettico,statoIniziale,&memoria);
+  return MemoriaFlussoChiudi(&memoria);
+}
@@ -0,0 +1,235 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ode.h>
+
+#define VERSIONE_TRAIETTORIA 1
+
+static const char MagiaTraiettoria[8]={'O','D','E','T','R','A','J','\0'};
+
+//Intestazione del file, 64 byte in modo che i record che seguono siano allineati
+struct IntestazioneTraiettoria{
+  char magia[8];
+  uint64_t versione;
+  uint64_t n; //Dimensione dello stato, ogni record contiene n+1 double
+  uint64_t numeroRecord;
+  uint64_t numeroBlocchi;
+  uint64_t posizioneIndice; //0 se l'indice non e' stato scritto, ad esempio se la scrittura e' stata interrotta
+  uint64_t riservato[2];
+};
+
+struct ScrittoreTraiettoria{
+  FILE* file;
+  size_t n;
+  size_t recordPerBlocco;
+  double* blocco; //Blocco in scrittura, recordPerBlocco record di n+1 double
+  size_t nelBlocco;
+  struct BloccoTraiettoria* indice;
+  size_t capacitaIndice;
+  struct IntestazioneTraiettoria intestazione;
+  int errore;
+};
+
+static size_t DoubleRecord(size_t n){
+  return n+1;
+}
+
+static int ScriviIntestazioneTraiettoria(struct ScrittoreTraiettoria* scrittore){
+  if(fseek(scrittore->file,0,SEEK_SET) != 0) return 1;
+  if(fwrite(&(scrittore->intestazione),sizeof(struct IntestazioneTraiettoria),1,scrittore->file) != 1) return 1;
+  return 0;
+}
+
+//Posizione della fine dei record, dove inizia il prossimo blocco
+static long FineRecord(const struct ScrittoreTraiettoria* scrittore){
+  return (long)(sizeof(struct IntestazioneTraiettoria)+scrittore->intestazione.numeroRecord*DoubleRecord(scrittore->n)*sizeof(double));
+}
+
+//Scrive il blocco corrente dopo gli ultimi record e aggiorna l'intestazione, l'indice resta in memoria fino alla chiusura
+static int SvuotaBlocco(struct ScrittoreTraiettoria* scrittore){
+  if(scrittore->nelBlocco == 0) return 0;
+  const size_t doubleRecord=DoubleRecord(scrittore->n);
+  if(scrittore->intestazione.numeroBlocchi == scrittore->capacitaIndice){
+    scrittore->capacitaIndice= scrittore->capacitaIndice ? 2*scrittore->capacitaIndice : 16;
+    scrittore->indice=(struct BloccoTraiettoria*)realloc(scrittore->indice,scrittore->capacitaIndice*sizeof(struct BloccoTraiettoria));
+  }
+  struct BloccoTraiettoria* blocco=scrittore->indice+scrittore->intestazione.numeroBlocchi;
+  blocco->posizione=(uint64_t)FineRecord(scrittore);
+  blocco->primoRecord=scrittore->intestazione.numeroRecord;
+  blocco->numeroRecord=scrittore->nelBlocco;
+  blocco->tInizio=scrittore->blocco[0];
+  blocco->tFine=scrittore->blocco[(scrittore->nelBlocco-1)*doubleRecord];
+
+  if(fseek(scrittore->file,(long)blocco->posizione,SEEK_SET) != 0) return 1;
+  if(fwrite(scrittore->blocco,sizeof(double)*doubleRecord,scrittore->nelBlocco,scrittore->file) != scrittore->nelBlocco) return 1;
+  scrittore->intestazione.numeroRecord+=scrittore->nelBlocco;
+  ++(scrittore->intestazione.numeroBlocchi);
+  scrittore->intestazione.posizioneIndice=0;
+  scrittore->nelBlocco=0;
+  return ScriviIntestazioneTraiettoria(scrittore);
+}
+
+struct ScrittoreTraiettoria* TraiettoriaApri(const char* percorso,size_t n,size_t recordPerBlocco,bool aggiungi){
+  struct ScrittoreTraiettoria* scrittore=(struct ScrittoreTraiettoria*)calloc(1,sizeof(struct ScrittoreTraiettoria));
+  scrittore->n=n;
+  scrittore->recordPerBlocco= recordPerBlocco ? recordPerBlocco : 4096;
+
+  //In aggiunta si riparte dall'intestazione e dall'indice esistenti
+  scrittore->file= aggiungi ? fopen(percorso,"r+b") : NULL;
+  if(scrittore->file){
+    struct IntestazioneTraiettoria* intestazione=&(scrittore->intestazione);
+    bool valido= fread(intestazione,sizeof(struct IntestazioneTraiettoria),1,scrittore->file) == 1
+      && memcmp(intestazione->magia,MagiaTraiettoria,sizeof(MagiaTraiettoria)) == 0
+      && intestazione->versione == VERSIONE_TRAIETTORIA && intestazione->n == n;
+    if(valido && intestazione->numeroBlocchi > 0){
+      scrittore->capacitaIndice=intestazione->numeroBlocchi;
+      scrittore->indice=(struct BloccoTraiettoria*)malloc(scrittore->capacitaIndice*sizeof(struct BloccoTraiettoria));
+      //Senza indice su disco i blocchi precedenti vengono considerati come uno solo
+      if(intestazione->posizioneIndice == 0 || fseek(scrittore->file,(long)intestazione->posizioneIndice,SEEK_SET) != 0
+         || fread(scrittore->indice,sizeof(struct BloccoTraiettoria),intestazione->numeroBlocchi,scrittore->file) != intestazione->numeroBlocchi){
+        intestazione->numeroBlocchi=0;
+        if(intestazione->numeroRecord > 0){
+          double tInizio,tFine;
+          const long ultimo=FineRecord(scrittore)-(long)(DoubleRecord(n)*sizeof(double));
+          valido= fseek(scrittore->file,(long)sizeof(struct IntestazioneTraiettoria),SEEK_SET) == 0 && fread(&tInizio,sizeof(double),1,scrittore->file) == 1
+            && fseek(scrittore->file,ultimo,SEEK_SET) == 0 && fread(&tFine,sizeof(double),1,scrittore->file) == 1;
+          struct BloccoTraiettoria unico={sizeof(struct IntestazioneTraiettoria),0,intestazione->numeroRecord,tInizio,tFine};
+          scrittore->indice[0]=unico;
+          intestazione->numeroBlocchi=1;
+        }
+      }
+    }
+    if(!valido){
+      fclose(scrittore->file);
+      free(scrittore->indice);
+      free(scrittore);
+      return NULL;
+    }
+  }else{
+    scrittore->file=fopen(percorso,"w+b");
+    if(scrittore->file == NULL){
+      free(scrittore);
+      return NULL;
+    }
+    struct IntestazioneTraiettoria intestazione={{0},VERSIONE_TRAIETTORIA,n,0,0,0,{0,0}};
+    memcpy(intestazione.magia,MagiaTraiettoria,sizeof(MagiaTraiettoria));
+    scrittore->intestazione=intestazione;
+    scrittore->errore=ScriviIntestazioneTraiettoria(scrittore);
+  }
+  scrittore->blocco=(double*)malloc(scrittore->recordPerBlocco*DoubleRecord(n)*sizeof(double));
+  return scrittore;
+}
+
+int TraiettoriaScrivi(struct ScrittoreTraiettoria* scrittore,double t,const gsl_vector* stato){
+  if(scrittore->errore) return 1;
+  double* record=scrittore->blocco+scrittore->nelBlocco*DoubleRecord(scrittore->n);
+  record[0]=t;
+  for(size_t i=0; i<scrittore->n; ++i) record[i+1]=gsl_vector_get(stato,i);
+  if(++(scrittore->nelBlocco) == scrittore->recordPerBlocco) scrittore->errore=SvuotaBlocco(scrittore);
+  return scrittore->errore;
+}
+
+int TraiettoriaChiudi(struct ScrittoreTraiettoria* scrittore){
+  int errore=scrittore->errore;
+  if(errore == 0) errore=SvuotaBlocco(scrittore);
+
+  //Indice dei blocchi dopo l'ultimo record
+  if(errore == 0){
+    const long posizione=FineRecord(scrittore);
+    const size_t numeroBlocchi=scrittore->intestazione.numeroBlocchi;
+    if(fseek(scrittore->file,posizione,SEEK_SET) != 0 || fwrite(scrittore->indice,sizeof(struct BloccoTraiettoria),numeroBlocchi,scrittore->file) != numeroBlocchi){
+      errore=1;
+    }else{
+      scrittore->intestazione.posizioneIndice=(uint64_t)posizione;
+      errore=ScriviIntestazioneTraiettoria(scrittore);
+    }
+  }
+  if(fclose(scrittore->file) != 0) errore=1;
+  free(scrittore->blocco);
+  free(scrittore->indice);
+  free(scrittore);
+  return errore;
+}
+
+struct LettoreTraiettoria* TraiettoriaLeggi(const char* percorso){
+  int descrittore=open(percorso,O_RDONLY);
+  if(descrittore < 0) return NULL;
+  struct stat informazioni;
+  if(fstat(descrittore,&informazioni) != 0 || (size_t)informazioni.st_size < sizeof(struct IntestazioneTraiettoria)){
+    close(descrittore);
+    return NULL;
+  }
+  const size_t dimensione=(size_t)informazioni.st_size;
+  void* mappa=mmap(NULL,dimensione,PROT_READ,MAP_SHARED,descrittore,0);
+  close(descrittore);
+  if(mappa == MAP_FAILED) return NULL;
+
+  //Verifica dell'intestazione e delle dimensioni dichiarate
+  const struct IntestazioneTraiettoria* intestazione=(const struct IntestazioneTraiettoria*)mappa;
+  const size_t fineRecord=sizeof(struct IntestazioneTraiettoria)+intestazione->numeroRecord*DoubleRecord(intestazione->n)*sizeof(double);
+  if(memcmp(intestazione->magia,MagiaTraiettoria,sizeof(MagiaTraiettoria)) != 0 || intestazione->versione != VERSIONE_TRAIETTORIA || fineRecord > dimensione){
+    munmap(mappa,dimensione);
+    return NULL;
+  }
+  struct LettoreTraiettoria* lettore=(struct LettoreTraiettoria*)malloc(sizeof(struct LettoreTraiettoria));
+  lettore->n=intestazione->n;
+  lettore->numeroRecord=intestazione->numeroRecord;
+  lettore->record=(const double*)((const char*)mappa+sizeof(struct IntestazioneTraiettoria));
+  lettore->blocchi=NULL;
+  lettore->numeroBlocchi=0;
+  if(intestazione->posizioneIndice >= fineRecord && intestazione->posizioneIndice+intestazione->numeroBlocchi*sizeof(struct BloccoTraiettoria) <= dimensione){
+    lettore->blocchi=(const struct BloccoTraiettoria*)((const char*)mappa+intestazione->posizioneIndice);
+    lettore->numeroBlocchi=intestazione->numeroBlocchi;
+  }
+  lettore->mappa=mappa;
+  lettore->dimensioneMappa=dimensione;
+  return lettore;
+}
+
+void TraiettoriaLibera(struct LettoreTraiettoria* lettore){
+  munmap(lettore->mappa,lettore->dimensioneMappa);
+  free(lettore);
+}
+
+gsl_matrix_const_view TraiettoriaStati(const struct LettoreTraiettoria* lettore,size_t primo,size_t numero){
+  const size_t doubleRecord=DoubleRecord(lettore->n);
+  return gsl_matrix_const_view_array_with_tda(lettore->record+primo*doubleRecord+1,numero,lettore->n,doubleRecord);
+}
+
+gsl_vector_const_view TraiettoriaIstanti(const struct LettoreTraiettoria* lettore,size_t primo,size_t numero){
+  const size_t doubleRecord=DoubleRecord(lettore->n);
+  return gsl_vector_const_view_array_with_stride(lettore->record+primo*doubleRecord,doubleRecord,numero);
+}
+
+gsl_vector_const_view TraiettoriaComponente(const struct LettoreTraiettoria* lettore,size_t componente,size_t primo,size_t numero){
+  const size_t doubleRecord=DoubleRecord(lettore->n);
+  return gsl_vector_const_view_array_with_stride(lettore->record+primo*doubleRecord+1+componente,doubleRecord,numero);
+}
+
+size_t TraiettoriaCerca(const struct LettoreTraiettoria* lettore,double t){
+  const size_t doubleRecord=DoubleRecord(lettore->n);
+  size_t basso=0,alto=lettore->numeroRecord;
+
+  //Con l'indice si restringe la ricerca al blocco che contiene t
+  if(lettore->blocchi){
+    size_t b=0,e=lettore->numeroBlocchi;
+    while(b < e){
+      size_t medio=(b+e)/2;
+      if(lettore->blocchi[medio].tFine < t) b=medio+1;
+      else e=medio;
+    }
+    if(b == lettore->numeroBlocchi) return lettore->numeroRecord;
+    basso=lettore->blocchi[b].primoRecord;
+    alto=basso+lettore->blocchi[b].numeroRecord;
+  }
+  while(basso < alto){
+    size_t medio=(basso+alto)/2;
+    if(lettore->record[medio*doubleRecord] < t) basso=medio+1;
+    else alto=medio;
+  }
+  return basso;
+}
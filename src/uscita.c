@@ -0,0 +1,96 @@
+#include <math.h>
+#include <ode.h>
+#include "ode_interno.h"
+
+int ScriviIntestazione(FILE* file,const struct InfoMatrice* intestazione){
+  if(fwrite(intestazione,sizeof(struct InfoMatrice),1,file) == 0) return 1;
+  return 0;
+}
+
+void MemoriaCompletaInit(struct MemoriaRisultato* memoria,size_t n,size_t campioni,enum Disposizione disposizione){
+  gsl_matrix* O_sim=AllocaRisultato(n,campioni,disposizione);
+  gsl_matrix_set_zero(O_sim);
+  MemoriaEsternaInit(memoria,O_sim,disposizione);
+}
+
+void MemoriaEsternaInit(struct MemoriaRisultato* memoria,gsl_matrix* O_sim,enum Disposizione disposizione){
+  memoria->O_sim=O_sim;
+  memoria->disposizione=disposizione;
+  memoria->finestra=0;
+  memoria->uscita=NULL;
+  memoria->prossimoIstante=0;
+  memoria->posizioneIntestazione=-1;
+  memoria->errore=0;
+}
+
+void MemoriaFlussoInit(struct MemoriaRisultato* memoria,size_t n,struct InfoUscita* uscita,const struct InfoBaseSimulazione* infoSimulazione){
+  //Ai metodi basta lo stato precedente e quello in calcolo
+  memoria->finestra=2;
+  memoria->disposizione=DisposizioneRighe;
+  memoria->O_sim=AllocaRisultato(n,memoria->finestra,memoria->disposizione);
+  memoria->uscita=uscita;
+  memoria->prossimoIstante=0;
+  memoria->posizioneIntestazione=-1;
+  memoria->errore=0;
+  //Senza uscita viene conservato solo l'ultimo stato, come nei propagatori di Parareal
+  if(uscita == NULL) return;
+  uscita->emessi=0;
+  
+  //Intestazione compatibile con fwrite_risultato, il numero di passi viene aggiornato alla chiusura
+  if(uscita->file){
+    const size_t decimazione= uscita->decimazione > 1 ? uscita->decimazione : 1;
+    struct InfoMatrice intestazione={
+      .dimensioneStruct=sizeof(struct InfoMatrice),
+      .righe=n,
+      .colonne=0,
+      .h= uscita->istanti ? 0.0 : infoSimulazione->h*(double)decimazione,
+      .T=infoSimulazione->T,
+      .t0=infoSimulazione->t0,
+      .disposizione=(size_t)DisposizioneRighe
+    };
+    memoria->intestazione=intestazione;
+    memoria->posizioneIntestazione=ftell(uscita->file);
+    if(ScriviIntestazione(uscita->file,&intestazione) != 0) memoria->errore=1;
+  }
+}
+
+int MemoriaFlussoChiudi(struct MemoriaRisultato* memoria){
+  struct InfoUscita* uscita=memoria->uscita;
+  if(uscita && uscita->file && memoria->errore == 0){
+    //Riscrivo l'intestazione con il numero di stati emessi se il file lo permette
+    memoria->intestazione.colonne=uscita->emessi;
+    if(memoria->posizioneIntestazione >= 0 && fseek(uscita->file,memoria->posizioneIntestazione,SEEK_SET) == 0){
+      if(ScriviIntestazione(uscita->file,&(memoria->intestazione)) != 0) memoria->errore=1;
+      fseek(uscita->file,0,SEEK_END);
+    }
+    if(fflush(uscita->file) != 0) memoria->errore=1;
+  }
+  gsl_matrix_free(memoria->O_sim);
+  return memoria->errore;
+}
+
+void EmettiStato(struct MemoriaRisultato* memoria,size_t k,double t){
+  struct InfoUscita* uscita=memoria->uscita;
+  if(uscita == NULL) return;
+  
+  //Selezione degli stati da emettere: primo stato oltre ogni istante richiesto oppure uno ogni decimazione passi
+  bool emetti=false;
+  if(uscita->istanti){
+    while(memoria->prossimoIstante < uscita->numeroIstanti){
+      double istante=uscita->istanti[memoria->prossimoIstante];
+      if(t < istante-1e-12*(1.0+fabs(istante))) break;
+      emetti=true;
+      ++(memoria->prossimoIstante);
+    }
+  }else{
+    const size_t decimazione= uscita->decimazione > 1 ? uscita->decimazione : 1;
+    emetti= k%decimazione == 0;
+  }
+  if(!emetti) return;
+  
+  gsl_vector_view stato=StatoMemoria(memoria,k);
+  if(uscita->funzione) uscita->funzione(t,&(stato.vector),uscita->dati);
+  if(uscita->file && memoria->errore == 0 && gsl_vector_fwrite(uscita->file,&(stato.vector)) != 0) memoria->errore=1;
+  if(uscita->traiettoria && memoria->errore == 0 && TraiettoriaScrivi(uscita->traiettoria,t,&(stato.vector)) != 0) memoria->errore=1;
+  ++(uscita->emessi);
+}